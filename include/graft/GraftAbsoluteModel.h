@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_ABSOLUTE_MODEL_H
+#define GRAFT_ABSOLUTE_MODEL_H
+
+#include <cmath>
+#include <Eigen/Dense>
+#include <ros/console.h>
+#include <graft/GraftScalar.h>
+#include <graft/GraftState.h>
+#include <graft/GraftQuaternion.h>
+#include <graft/GraftMeasurementSet.h>
+#include <graft/GraftInitialization.h>
+#include <nav_msgs/Odometry.h>
+
+// Pose, body velocity and body rates: x, y, z, qw, qx, qy, qz, vx, vy, vz, wx, wy, wz
+struct GraftAbsoluteModel{
+  enum { SIZE = 13 };
+  typedef Eigen::Matrix<GraftScalar, SIZE, 1> StateVector;
+
+  static const char* name(){
+    return "absolute";
+  }
+
+  static void initialState(StateVector& x){
+    x.setZero();
+    x(3) = 1.0; // Normalize quaternion
+  }
+
+  static unsigned int requiredInitialization(){
+    return GRAFT_INIT_POSITION | GRAFT_INIT_ORIENTATION | GRAFT_INIT_LINEAR_VELOCITY;
+  }
+
+  // Seeds the state from one measurement, returns the GraftInitialization parts it set
+  template<typename Covariance>
+  static unsigned int initialize(const graft::GraftSensorResidual& meas, StateVector& x, Covariance& P){
+    unsigned int seeded = 0;
+    double position[3] = {meas.pose.position.x, meas.pose.position.y, meas.pose.position.z};
+    double linear[3] = {meas.twist.linear.x, meas.twist.linear.y, meas.twist.linear.z};
+    double angular[3] = {meas.twist.angular.x, meas.twist.angular.y, meas.twist.angular.z};
+    for(int k = 0; k < 3; k++){
+      if(meas.pose_covariance[7*k] > 1e-20){
+        seedElement(x, P, k, position[k], meas.pose_covariance[7*k]);
+        seeded |= GRAFT_INIT_POSITION;
+      }
+      if(meas.twist_covariance[7*k] > 1e-20){
+        seedElement(x, P, 7 + k, linear[k], meas.twist_covariance[7*k]);
+        seeded |= GRAFT_INIT_LINEAR_VELOCITY;
+      }
+      if(meas.twist_covariance[21+7*k] > 1e-20){
+        seedElement(x, P, 10 + k, angular[k], meas.twist_covariance[21+7*k]);
+        seeded |= GRAFT_INIT_ANGULAR_VELOCITY;
+      }
+    }
+    if(meas.pose_covariance[21] > 1e-20 || meas.pose_covariance[28] > 1e-20 || meas.pose_covariance[35] > 1e-20){
+      if(seedQuaternion(x, P, 3, meas.pose.orientation, meas.pose_covariance)){
+        seeded |= GRAFT_INIT_ORIENTATION;
+      }
+    }
+    return seeded;
+  }
+
+  static StateVector f(const StateVector& x, const double dt){
+    StateVector out = x;
+    out.block<3, 1>(0, 0) += transformVelocities(x.block<3, 1>(7, 0), x.block<4, 1>(3, 0))*GraftScalar(dt);
+    out.block<4, 1>(3, 0) = updatedQuaternion(x.block<4, 1>(3, 0), x(10), x(11), x(12), dt);
+    return out;
+  }
+
+  static StateVector extrapolate(const StateVector& x, const double dt){
+    return f(x, dt);
+  }
+
+  static void normalize(StateVector& x){
+    x.block<4, 1>(3, 0) = unitQuaternion(x.block<4, 1>(3, 0));
+  }
+
+  // Longest prediction step, longer intervals are integrated in steps of this
+  static double maxTimeStep(){
+    return 0.2;
+  }
+
+  static void toMessage(const StateVector& x, graft::GraftState& msg){
+    Eigen::Matrix<GraftScalar, 4, 1> q = unitQuaternion(x.block<4, 1>(3, 0));
+    msg.pose.position.x = x(0);
+    msg.pose.position.y = x(1);
+    msg.pose.position.z = x(2);
+    msg.pose.orientation.w = q(0);
+    msg.pose.orientation.x = q(1);
+    msg.pose.orientation.y = q(2);
+    msg.pose.orientation.z = q(3);
+    msg.twist.linear.x = x(7);
+    msg.twist.linear.y = x(8);
+    msg.twist.linear.z = x(9);
+    msg.twist.angular.x = x(10);
+    msg.twist.angular.y = x(11);
+    msg.twist.angular.z = x(12);
+  }
+
+  static void addMeasurements(const graft::GraftSensorResidual& meas, const GraftMeasurementSet::Residuals& residuals, GraftMeasurementSet& measurements){
+    if(meas.pose_covariance[0] > 1e-20){
+      measurements.add(meas, meas.pose_covariance[0], residuals, residualPositionX);
+    }
+    if(meas.pose_covariance[7] > 1e-20){
+      measurements.add(meas, meas.pose_covariance[7], residuals, residualPositionY);
+    }
+    if(meas.pose_covariance[14] > 1e-20){
+      measurements.add(meas, meas.pose_covariance[14], residuals, residualPositionZ);
+    }
+
+    // Orientation X, Y, Z and W
+    //  I'm going to treat these as inseperable due to the complexity of
+    //  calculating the quaternion covariance from the rpy covariance
+    if(meas.pose_covariance[21] > 1e-20
+        || meas.pose_covariance[28] > 1e-20
+        || meas.pose_covariance[35] > 1e-20 ) {
+      Eigen::Matrix<GraftScalar, 4, 1> quaternion_cov = quaternionCovFromEuler(meas.pose_covariance[21],
+          meas.pose_covariance[28], meas.pose_covariance[35], meas.pose.orientation.x,
+          meas.pose.orientation.y, meas.pose.orientation.z, meas.pose.orientation.w);
+      if( !std::isfinite(quaternion_cov(0)) ||
+          !std::isfinite(quaternion_cov(1)) ||
+          !std::isfinite(quaternion_cov(2)) ||
+          !std::isfinite(quaternion_cov(3)) ) {
+        ROS_ERROR("Quaternion covariance is not finite!");
+        ROS_ERROR_STREAM("Quaternion:\n" << meas.pose.orientation);
+        ROS_ERROR_STREAM("RPY covariance: " << meas.pose_covariance[21] << ", " <<
+            meas.pose_covariance[28] << ", " << meas.pose_covariance[35]);
+        ROS_ERROR_STREAM("Quaternion covariance:\n" << quaternion_cov);
+      } else {
+        measurements.add(meas, quaternion_cov(0), residuals, residualOrientationX);
+        measurements.add(meas, quaternion_cov(1), residuals, residualOrientationY);
+        measurements.add(meas, quaternion_cov(2), residuals, residualOrientationZ);
+        measurements.add(meas, quaternion_cov(3), residuals, residualOrientationW);
+      }
+    }
+
+    if(meas.twist_covariance[0] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[0], residuals, residualLinearVelocityX);
+    }
+    if(meas.twist_covariance[7] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[7], residuals, residualLinearVelocityY);
+    }
+    if(meas.twist_covariance[14] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[14], residuals, residualLinearVelocityZ);
+    }
+    if(meas.twist_covariance[21] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[21], residuals, residualAngularVelocityX);
+    }
+    if(meas.twist_covariance[28] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[28], residuals, residualAngularVelocityY);
+    }
+    if(meas.twist_covariance[35] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[35], residuals, residualAngularVelocityZ);
+    }
+  }
+
+  static void toOdometry(const graft::GraftState& state, const double dt, nav_msgs::Odometry& odom){
+    odom.pose.pose = state.pose;
+    odom.twist.twist = state.twist;
+  }
+};
+
+#endif
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_ALLOCATION_AUDIT_H
+#define GRAFT_ALLOCATION_AUDIT_H
+
+#include <stdint.h>
+
+// Heap allocations counted per filter stage, built with
+// -DGRAFT_ALLOCATION_AUDIT=ON.  malloc and its relatives are interposed, so
+// this sees Eigen, std containers and message construction alike.  Counts
+// are kept per thread, a stage is whatever GraftAllocationScope the calling
+// thread is in.  Without the option nothing is counted.
+class GraftAllocationAudit{
+  public:
+    enum Stage{
+      OTHER,
+      PREDICTION, // Sigma points through the process model
+      MEASUREMENTS, // z() and stacking the measurements
+      OBSERVATION, // h() of every sigma point
+      UPDATE, // Gain, gating and covariance update
+      OUTPUT, // Filling the messages to publish
+      STAGES
+    };
+
+    struct Counts{
+      uint64_t allocations[STAGES];
+      uint64_t bytes[STAGES];
+    };
+
+    // True if built with the audit
+    static bool enabled();
+
+    // Totals of the calling thread since it started
+    static void get(Counts& counts);
+
+    static const char* name(const Stage stage);
+};
+
+// Counts the allocations of the calling thread against a stage until it is
+// destroyed or enters another, then the enclosing stage counts again.  With
+// -DGRAFT_ALLOCATION_AUDIT_STRICT=ON, Eigen asserts on any heap allocation
+// in the PREDICTION and UPDATE stages, through EIGEN_RUNTIME_NO_MALLOC.
+#ifdef GRAFT_ALLOCATION_AUDIT
+class GraftAllocationScope{
+  public:
+    explicit GraftAllocationScope(const GraftAllocationAudit::Stage stage);
+
+    ~GraftAllocationScope();
+
+    void enter(const GraftAllocationAudit::Stage stage);
+
+  private:
+    GraftAllocationAudit::Stage previous_;
+};
+#else
+class GraftAllocationScope{
+  public:
+    explicit GraftAllocationScope(const GraftAllocationAudit::Stage stage){}
+
+    void enter(const GraftAllocationAudit::Stage stage){}
+};
+#endif
+
+#endif
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_ATTITUDE_MODEL_H
+#define GRAFT_ATTITUDE_MODEL_H
+
+#include <cmath>
+#include <Eigen/Dense>
+#include <graft/GraftScalar.h>
+#include <graft/GraftState.h>
+#include <graft/GraftQuaternion.h>
+#include <graft/GraftMeasurementSet.h>
+#include <graft/GraftInitialization.h>
+#include <nav_msgs/Odometry.h>
+
+// Orientation and body rates: qw, qx, qy, qz, wx, wy, wz
+struct GraftAttitudeModel{
+  enum { SIZE = 7 };
+  typedef Eigen::Matrix<GraftScalar, SIZE, 1> StateVector;
+
+  static const char* name(){
+    return "attitude";
+  }
+
+  static void initialState(StateVector& x){
+    x.setZero();
+    x(0) = 1.0; // Normalize quaternion
+  }
+
+  static unsigned int requiredInitialization(){
+    return GRAFT_INIT_ORIENTATION | GRAFT_INIT_ANGULAR_VELOCITY;
+  }
+
+  // Seeds the state from one measurement, returns the GraftInitialization parts it set
+  template<typename Covariance>
+  static unsigned int initialize(const graft::GraftSensorResidual& meas, StateVector& x, Covariance& P){
+    unsigned int seeded = 0;
+    double roll, pitch;
+    if(meas.pose_covariance[21] > 1e-20 || meas.pose_covariance[28] > 1e-20 || meas.pose_covariance[35] > 1e-20){
+      if(seedQuaternion(x, P, 0, meas.pose.orientation, meas.pose_covariance)){
+        seeded |= GRAFT_INIT_ORIENTATION;
+      }
+    } else if(meas.accel_covariance[0] > 1e-20 && meas.accel_covariance[4] > 1e-20 && meas.accel_covariance[8] > 1e-20
+              && rollPitchFromAcceleration(meas.accel, roll, pitch)){ // Level from gravity, yaw stays zero
+      geometry_msgs::Quaternion q = tf::createQuaternionMsgFromRollPitchYaw(roll, pitch, 0.0);
+      x(0) = q.w;
+      x(1) = q.x;
+      x(2) = q.y;
+      x(3) = q.z;
+      seeded |= GRAFT_INIT_ORIENTATION;
+    }
+    for(int k = 0; k < 3; k++){
+      if(meas.twist_covariance[21+7*k] > 1e-20){
+        double w = k == 0 ? meas.twist.angular.x : (k == 1 ? meas.twist.angular.y : meas.twist.angular.z);
+        seedElement(x, P, 4 + k, w, meas.twist_covariance[21+7*k]);
+        seeded |= GRAFT_INIT_ANGULAR_VELOCITY;
+      }
+    }
+    return seeded;
+  }
+
+  static StateVector f(const StateVector& x, const double dt){
+    StateVector out;
+    out.block<4, 1>(0, 0) = updatedQuaternion(x.block<4, 1>(0, 0), x(4), x(5), x(6), dt);
+    out.block<3, 1>(4, 0) = x.block<3, 1>(4, 0);
+    return out;
+  }
+
+  static StateVector extrapolate(const StateVector& x, const double dt){
+    return f(x, dt);
+  }
+
+  static void normalize(StateVector& x){
+    x.block<4, 1>(0, 0) = unitQuaternion(x.block<4, 1>(0, 0));
+  }
+
+  // Longest prediction step, 0 for no limit
+  static double maxTimeStep(){
+    return 0.0;
+  }
+
+  static void toMessage(const StateVector& x, graft::GraftState& msg){
+    msg.pose.orientation.w = x(0);
+    msg.pose.orientation.x = x(1);
+    msg.pose.orientation.y = x(2);
+    msg.pose.orientation.z = x(3);
+    msg.twist.angular.x = x(4);
+    msg.twist.angular.y = x(5);
+    msg.twist.angular.z = x(6);
+  }
+
+  // Angular velocity and the direction of the measured acceleration
+  static void addMeasurements(const graft::GraftSensorResidual& meas, const GraftMeasurementSet::Residuals& residuals, GraftMeasurementSet& measurements){
+    if(meas.twist_covariance[21] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[21], residuals, residualAngularVelocityX);
+    }
+    if(meas.twist_covariance[28] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[28], residuals, residualAngularVelocityY);
+    }
+    if(meas.twist_covariance[35] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[35], residuals, residualAngularVelocityZ);
+    }
+    if(meas.accel_covariance[0] > 1e-20 && meas.accel_covariance[4] > 1e-20 && meas.accel_covariance[8] > 1e-20){
+      measurements.add(meas, meas.accel_covariance[0], residuals, accelDirectionX);
+      measurements.add(meas, meas.accel_covariance[4], residuals, accelDirectionY);
+      measurements.add(meas, meas.accel_covariance[8], residuals, accelDirectionZ);
+    }
+  }
+
+  // Gravity direction fields, the accelerometer only measures orientation
+  static double accelDirectionX(const graft::GraftSensorResidual& r){
+    return r.accel.x / magnitude(r.accel);
+  }
+
+  static double accelDirectionY(const graft::GraftSensorResidual& r){
+    return r.accel.y / magnitude(r.accel);
+  }
+
+  static double accelDirectionZ(const graft::GraftSensorResidual& r){
+    return r.accel.z / magnitude(r.accel);
+  }
+
+  static void toOdometry(const graft::GraftState& state, const double dt, nav_msgs::Odometry& odom){
+    odom.pose.pose.orientation = state.pose.orientation;
+    odom.twist.twist.angular = state.twist.angular;
+  }
+
+  static double magnitude(const geometry_msgs::Vector3& v){
+    return std::sqrt(v.x*v.x + v.y*v.y + v.z*v.z);
+  }
+};
+
+#endif
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_CHECKPOINT_H
+#define GRAFT_CHECKPOINT_H
+
+// Warm start across restarts.  The filter posterior, the published odometry
+// pose and the previous message of each delta sensor are copied into a
+// memory mapped file, which outlives the process, and read back at startup.
+//
+// The file holds two slots written alternately.  A slot's sequence is odd
+// while it is being written, so a crash mid-write leaves the other slot as
+// the newest complete checkpoint.
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include <boost/shared_ptr.hpp>
+#include <graft/GraftSensor.h>
+#include <nav_msgs/Odometry.h>
+
+#define GRAFT_CHECKPOINT_MAGIC 0x47524350 // "GRCP"
+#define GRAFT_CHECKPOINT_VERSION 1
+#define GRAFT_CHECKPOINT_MAX_SENSORS 16
+
+struct GraftCheckpointSensor{
+  char name[64];
+  uint32_t stamp_sec;
+  uint32_t stamp_nsec;
+
+  double position[3]; // x, y, z
+  double orientation[4]; // x, y, z, w
+};
+
+struct GraftCheckpointSlot{
+  uint32_t sequence; // Odd while the slot is being written
+  uint32_t size; // Filter state size, covariance holds size*size elements
+  uint32_t stamp_sec;
+  uint32_t stamp_nsec;
+  char process_model[16];
+
+  double state[18];
+  double covariance[324]; // Row-major
+
+  double odometry_position[3];
+  double odometry_orientation[4];
+
+  uint32_t num_sensors;
+  uint32_t reserved;
+  GraftCheckpointSensor sensors[GRAFT_CHECKPOINT_MAX_SENSORS];
+};
+
+// Previous message of a delta sensor, as read back from a checkpoint
+struct GraftCheckpointMemory{
+  std::string name;
+  ros::Time stamp;
+  geometry_msgs::Pose pose;
+};
+
+struct GraftCheckpointFile{
+  uint32_t magic;
+  uint32_t version;
+
+  GraftCheckpointSlot slots[2];
+};
+
+class GraftCheckpoint{
+  public:
+    GraftCheckpoint();
+
+    ~GraftCheckpoint();
+
+    // Maps the file, creating it if needed
+    bool open(const std::string& path);
+
+    void close();
+
+    bool isOpen();
+
+    void write(const std::string& process_model, const ros::Time& stamp, const std::vector<double>& state,
+               const std::vector<double>& covariance, const nav_msgs::Odometry& odom,
+               const std::vector<boost::shared_ptr<GraftSensor> >& topics);
+
+    // Newest complete checkpoint of process_model written at most max_age
+    // seconds ago.  Nothing is applied to the topics, restore the delta
+    // memory with restoreMemory once the filter has accepted the posterior.
+    bool read(const std::string& process_model, const double max_age, ros::Time& stamp,
+              std::vector<double>& state, std::vector<double>& covariance, geometry_msgs::Pose& odom_pose,
+              std::vector<GraftCheckpointMemory>& memory);
+
+    // Copies the delta memory into the topics of the same name
+    static void restoreMemory(const std::vector<GraftCheckpointMemory>& memory,
+                              std::vector<boost::shared_ptr<GraftSensor> >& topics);
+
+  private:
+    // Slot with the highest even sequence, NULL if none has been written
+    const GraftCheckpointSlot* newestSlot();
+
+    std::string path_;
+    GraftCheckpointFile* data_;
+};
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_COVARIANCE_UPDATE_H
+#define GRAFT_COVARIANCE_UPDATE_H
+
+#include <graft/GraftScalar.h>
+
+// Joseph form of the posterior covariance P - K*S*K' written with the cross
+// covariance, so errors in K only enter at second order.  The result is
+// symmetrized, rounding would otherwise let P drift, most of all in float.
+// KS is a workspace the size of K, kept by the caller so steady updates do
+// not allocate.
+template<typename Derived, typename Gain>
+void josephCovarianceUpdate(Eigen::MatrixBase<Derived>& covariance, const Gain& K, const Gain& cross_covariance,
+                            const GraftMatrix& innovation_covariance, Gain& KS){
+  typedef Eigen::Matrix<typename Derived::Scalar, Derived::RowsAtCompileTime, Derived::ColsAtCompileTime> Square;
+  KS.noalias() = K*innovation_covariance;
+  Square KPxz;
+  KPxz.noalias() = K*cross_covariance.transpose();
+  Square KSK;
+  KSK.noalias() = KS*K.transpose();
+  Square out = covariance - KPxz - KPxz.transpose() + KSK;
+  covariance = (out + out.transpose())/2;
+}
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_FILTER_H
+#define GRAFT_FILTER_H
+
+#include <string>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <ros/ros.h>
+#include <graft/GraftFlightRecorder.h>
+#include <graft/GraftRecoveryEvent.h>
+#include <graft/GraftState.h>
+#include <graft/GraftStateCompact.h>
+#include <graft/GraftSensor.h>
+#include <nav_msgs/Odometry.h>
+
+// Interface of a filter, whatever its process model
+class GraftFilter{
+  public:
+    typedef boost::function<void(const graft::GraftRecoveryEvent&)> RecoveryFunction;
+
+    virtual ~GraftFilter(){}
+
+    virtual graft::GraftStatePtr getMessageFromState() = 0;
+
+    virtual graft::GraftStateCompactPtr getCompactMessageFromState() = 0;
+
+    virtual graft::GraftStatePtr getMessageAtTime(const ros::Time& stamp) = 0;
+
+    // Fill an existing message, reusing its storage
+    virtual void getMessageFromState(graft::GraftState& msg) = 0;
+
+    virtual void getCompactMessageFromState(graft::GraftStateCompact& msg) = 0;
+
+    // False if stamp is older than the state history
+    virtual bool getMessageAtTime(const ros::Time& stamp, graft::GraftState& msg) = 0;
+
+    // Time of the current estimate, the last update that fused measurements
+    virtual ros::Time getStateTime() = 0;
+
+    virtual double predictAndUpdate() = 0;
+
+    virtual double predictAndUpdate(std::vector<boost::shared_ptr<GraftSensor> >& topics) = 0;
+
+    virtual void setTopics(std::vector<boost::shared_ptr<GraftSensor> >& topics) = 0;
+
+    virtual void setInitialCovariance(std::vector<double>& P) = 0;
+
+    virtual void setProcessNoise(std::vector<double>& Q) = 0;
+
+    // Of each mode of a filter that runs several, in the order they were
+    // configured, a single filter has none and ignores it
+    virtual void setModeProcessNoise(std::vector<std::vector<double> >& Q) = 0;
+
+    virtual void setAlpha(const double alpha) = 0;
+
+    virtual void setKappa(const double kappa) = 0;
+
+    virtual void setBeta(const double beta) = 0;
+
+    virtual void setStateHistorySize(const size_t size) = 0;
+
+    // Wait for measurements to seed the state before the first update, up to timeout seconds if > 0
+    virtual void setInitializeFromMeasurements(const bool initialize, const double timeout) = 0;
+
+    // False until the state has been initialized
+    virtual bool isReady() = 0;
+
+    // A rejected posterior rolls back to the last healthy one with its covariance multiplied by
+    // inflation, after max_recoveries in a row the filter starts over from its initial state
+    virtual void setRecovery(const double inflation, const int max_recoveries) = 0;
+
+    // Called with each recovery
+    virtual void setRecoveryCallback(RecoveryFunction callback) = 0;
+
+    // Cheaper prediction when shedding load: only the mean is propagated and the
+    // process noise added to the covariance, the update is unchanged
+    virtual void setMeanOnlyPrediction(const bool mean_only) = 0;
+
+    // Records what each update saw, NULL stops recording
+    virtual void setFlightRecorder(GraftFlightRecorder* recorder) = 0;
+
+    // Updates the smoothed estimate lags behind the filter, 0 disables smoothing
+    virtual void setSmootherLag(const size_t lag) = 0;
+
+    // The estimate lag updates back, smoothed by the ones since.  False until
+    // there have been lag updates since the start or the last recovery.
+    virtual bool getSmoothedMessage(graft::GraftState& msg) = 0;
+
+    // Current state and row-major covariance for a checkpoint, false until the filter is ready
+    virtual bool getPosterior(std::vector<double>& state, std::vector<double>& covariance) = 0;
+
+    // Continue from a posterior checkpointed at stamp, false if it does not fit
+    // this filter or its covariance is not symmetric positive definite
+    virtual bool restorePosterior(const ros::Time& stamp, const std::vector<double>& state, const std::vector<double>& covariance) = 0;
+
+    // Number of states
+    virtual size_t size() = 0;
+
+    // Fills odom from a state of this filter, dt is the time since odom was last filled
+    virtual void updateOdometry(const graft::GraftState& state, const double dt, nav_msgs::Odometry& odom) = 0;
+};
+
+// velocity, attitude, absolute or inertial, returns NULL for other names
+boost::shared_ptr<GraftFilter> createGraftFilter(const std::string& process_model);
+
+#endif
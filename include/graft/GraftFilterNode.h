@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_FILTER_NODE_H
+#define GRAFT_FILTER_NODE_H
+
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+#include <boost/atomic.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <graft/GraftAllocationAudit.h>
+#include <graft/GraftCheckpoint.h>
+#include <graft/GraftFilter.h>
+#include <graft/GraftFlightRecorder.h>
+#include <graft/GraftLoadShedder.h>
+#include <graft/GraftParameterManager.h>
+#include <graft/GraftPublishingStage.h>
+#include <graft/GraftRealtimeLoop.h>
+#include <graft/GraftSharedStateWriter.h>
+#include <graft/GraftUpdateScheduler.h>
+#include <graft/GetState.h>
+#include <graft/GraftGateStatistics.h>
+#include <nav_msgs/Odometry.h>
+#include <std_srvs/Trigger.h>
+#include <std_msgs/Bool.h>
+#include <tf/transform_broadcaster.h>
+
+// One filter with its topics, update scheduler and outputs.  All of its
+// callbacks run on the callback queues of the node handles it is given,
+// except with 'realtime', where the topics and timed updates run on a
+// GraftRealtimeLoop.  Estimates are published by a GraftPublishingStage.
+class GraftFilterNode{
+  public:
+    typedef boost::function<void(const nav_msgs::Odometry&)> OdometryFunction;
+
+    GraftFilterNode(ros::NodeHandle n, ros::NodeHandle pnh);
+
+    ~GraftFilterNode();
+
+    // Loads the parameters and starts the filter, false if it can not run
+    bool init();
+
+    // Also called with each published odometry message
+    void setOdometryCallback(OdometryFunction callback);
+
+    GraftParameterManager& getParameterManager();
+
+  private:
+    void publishTF(const nav_msgs::Odometry& msg);
+
+    void publishOdometry(const graft::GraftState& state, const double dt);
+
+    bool getStateCallback(graft::GetState::Request& req, graft::GetState::Response& res);
+
+    // Applies parameters changed on the parameter server, see GraftParameterManager::reloadParameters
+    bool reloadParametersCallback(std_srvs::Trigger::Request& req, std_srvs::Trigger::Response& res);
+
+    void updateCallback(GraftUpdateGroup& group);
+
+    // Messages after an update, leaving out the covariance ones when shedding load
+    void collectUpdate(const double dt, GraftPublishSlot& slot);
+
+    // On the publishing stage
+    void publishSlot(const GraftPublishSlot& slot);
+
+    void publishSmoothedOdometry(const graft::GraftState& state);
+
+    // Publishes the statistics the real-time loop handed over
+    void publishCallback(const ros::TimerEvent& event);
+
+    // Called on the real-time loop
+    void realtimeStatisticsCallback(const graft::GraftRealtimeStatistics& statistics);
+
+    // Records how long an update took against update_deadline
+    void checkLoad(const double cycle_time);
+
+    // Adds the allocations of an update since before, reported periodically
+    void auditAllocations(const GraftAllocationAudit::Counts& before);
+
+    // Applies the current degradation level and hands it to the publishing stage
+    void applyLoadLevel(const double cycle_time);
+
+    // On the publishing stage
+    void publishLoadShedding(const graft::GraftLoadShedding& load_shedding);
+
+    void outputCallback(const ros::TimerEvent& event);
+
+    // Continues from the checkpoint file if it is fresh enough
+    void restoreCheckpoint();
+
+    void writeCheckpoint();
+
+    void checkpointCallback(const ros::TimerEvent& event);
+
+    void getGateStatistics(const ros::Time& stamp, graft::GraftGateStatistics& msg);
+
+    void recoveryCallback(const graft::GraftRecoveryEvent& event);
+
+    // Publishes the ready flag whenever it changes
+    bool checkReady();
+
+    ros::NodeHandle n_;
+    ros::NodeHandle pnh_;
+
+    GraftParameterManager manager_;
+    std::vector<boost::shared_ptr<GraftSensor> > topics_;
+    std::vector<ros::Subscriber> subs_;
+
+    boost::shared_ptr<GraftFilter> ukf_;
+    boost::shared_ptr<GraftUpdateScheduler> scheduler_;
+
+    ros::Publisher state_pub_;
+    ros::Publisher compact_state_pub_;
+    ros::Publisher odom_pub_;
+    ros::Publisher smoothed_pub_;
+    ros::Publisher ready_pub_;
+    ros::Publisher recovery_pub_;
+    ros::Publisher gate_pub_;
+    ros::Publisher load_pub_;
+    ros::Publisher realtime_pub_;
+    ros::ServiceServer state_srv_;
+    ros::ServiceServer reload_srv_;
+
+    nav_msgs::Odometry odom_; // Filled by the publishing stage
+    nav_msgs::Odometry smoothed_odom_; // Filled by the publishing stage
+    ros::Time last_smoothed_stamp_; // Of the last smoothed estimate collected
+    boost::mutex odom_mutex_; // Against checkpoints
+    boost::atomic<bool> ready_; // Also read by outputCallback on the ROS thread
+    OdometryFunction odometry_callback_;
+
+    // Same-host consumers
+    GraftSharedStateWriter shared_state_;
+
+    // Degrades the updates when they overrun update_deadline
+    GraftLoadShedder shedder_;
+    int max_priority_; // Of the update groups, the only ones run from PRIORITY_ONLY on
+    bool load_pending_; // The level changed while publishing was falling behind
+    double load_pending_cycle_time_;
+
+    // With GRAFT_ALLOCATION_AUDIT, allocations of the updates since the last report
+    GraftAllocationAudit::Counts audit_counts_;
+    unsigned int audit_cycles_;
+    ros::WallTime audit_report_time_;
+
+    // Dedicated update thread, if 'realtime' is set.  filter_mutex_ guards the
+    // filter and topics against the services and timers of the ROS thread.
+    typedef boost::lockfree::spsc_queue<graft::GraftRealtimeStatistics, boost::lockfree::capacity<4> > StatisticsQueue;
+    ros::CallbackQueue realtime_queue_;
+    boost::mutex filter_mutex_;
+    boost::shared_ptr<GraftRealtimeLoop> realtime_loop_;
+    StatisticsQueue realtime_statistics_;
+    ros::Timer publish_timer_;
+
+    // Publishes off the filter thread
+    GraftPublishingStage publisher_;
+
+    // Odometry and tf are published at this rate between updates, if set
+    double output_rate_;
+    ros::Time last_output_time_;
+    ros::Timer output_timer_;
+
+    // Warm start across restarts
+    GraftCheckpoint checkpoint_;
+    ros::Timer checkpoint_timer_;
+
+    // What each update saw, for offline replay
+    GraftFlightRecorder flight_recorder_;
+
+    // tf
+    bool publish_tf_;
+    boost::shared_ptr<tf::TransformBroadcaster> broadcaster_;
+
+    std::string parent_frame_id_;
+    std::string child_frame_id_;
+};
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_FIXED_LAG_SMOOTHER_H
+#define GRAFT_FIXED_LAG_SMOOTHER_H
+
+#include <ros/ros.h>
+#include <Eigen/Dense>
+#include <Eigen/StdVector>
+
+// Fixed-lag unscented Rauch-Tung-Striebel smoother over the last lag+1
+// posteriors of a filter.  Each update stores its prediction with the cross
+// covariance between the previous posterior's sigma points and their
+// propagation, then its posterior.  The smoothed estimate lag updates back
+// is found by one backward pass over the window:
+//
+//   D_k = C_k+1 (P-_k+1)^-1
+//   m_k = m_k + D_k (ms_k+1 - m-_k+1)
+//   P_k = P_k + D_k (Ps_k+1 - P-_k+1) D_k'
+//
+// The window is allocated once by setLag, so memory and the work of each
+// pass are bounded by the lag, and nothing is allocated after that.
+template<int N, typename Scalar = double>
+class GraftFixedLagSmoother{
+  public:
+    typedef Eigen::Matrix<Scalar, N, 1> StateVector;
+    typedef Eigen::Matrix<Scalar, N, N> CovarianceMatrix;
+
+    GraftFixedLagSmoother(){
+      setLag(0);
+    }
+
+    // Updates the smoothed estimate lags behind the newest, 0 disables smoothing
+    void setLag(const size_t lag){
+      lag_ = lag;
+      size_t capacity = lag > 0 ? lag + 1 : 0;
+      stamps_.assign(capacity, ros::Time());
+      states_.assign(capacity, StateVector::Zero());
+      covariances_.assign(capacity, CovarianceMatrix::Zero());
+      predicted_states_.assign(capacity, StateVector::Zero());
+      predicted_covariances_.assign(capacity, CovarianceMatrix::Zero());
+      gains_.assign(capacity, CovarianceMatrix::Zero());
+      linked_.assign(capacity, false);
+      clear();
+    }
+
+    size_t getLag() const{
+      return lag_;
+    }
+
+    // Forgets the window, after a recovery the estimates are no longer linked
+    void clear(){
+      next_ = 0;
+      count_ = 0;
+    }
+
+    // The prediction of the next posterior from the newest one.  Without a
+    // cross covariance, after a mean only prediction, the smoothed estimate
+    // does not reach back past this update.
+    void predict(const StateVector& mean, const CovarianceMatrix& covariance, const CovarianceMatrix* cross_covariance){
+      if(lag_ == 0){
+        return;
+      }
+      predicted_states_[next_] = mean;
+      predicted_covariances_[next_] = covariance;
+      linked_[next_] = cross_covariance != NULL && count_ > 0;
+      if(linked_[next_]){
+        // D = C P^-1, from P D' = C' as the covariance is symmetric
+        gains_[next_] = covariance.ldlt().solve(cross_covariance->transpose()).transpose();
+      }
+    }
+
+    // The posterior of the last prediction
+    void add(const ros::Time& stamp, const StateVector& state, const CovarianceMatrix& covariance){
+      if(lag_ == 0){
+        return;
+      }
+      stamps_[next_] = stamp;
+      states_[next_] = state;
+      covariances_[next_] = covariance;
+      next_ = (next_ + 1) % stamps_.size();
+      if(count_ < stamps_.size()){
+        count_++;
+      }
+    }
+
+    // The estimate lag updates back, smoothed by the ones since.  False until
+    // the window has filled.
+    bool smoothed(ros::Time& stamp, StateVector& state, CovarianceMatrix& covariance) const{
+      if(lag_ == 0 || count_ < stamps_.size()){
+        return false;
+      }
+      size_t i = index(count_-1);
+      state = states_[i];
+      covariance = covariances_[i];
+      for(size_t k = count_-1; k > 0; k--){
+        size_t next = index(k);
+        size_t previous = index(k-1);
+        if(!linked_[next]){
+          state = states_[previous];
+          covariance = covariances_[previous];
+          continue;
+        }
+        const CovarianceMatrix& D = gains_[next];
+        state = states_[previous] + D*(state - predicted_states_[next]);
+        covariance = covariances_[previous] + D*(covariance - predicted_covariances_[next])*D.transpose();
+      }
+      stamp = stamps_[index(0)];
+      return true;
+    }
+
+  private:
+
+    // i = 0 is the oldest stored entry
+    size_t index(size_t i) const{
+      return (next_ + stamps_.size() - count_ + i) % stamps_.size();
+    }
+
+    size_t lag_;
+    std::vector<ros::Time> stamps_;
+    std::vector<StateVector, Eigen::aligned_allocator<StateVector> > states_;
+    std::vector<CovarianceMatrix, Eigen::aligned_allocator<CovarianceMatrix> > covariances_;
+    std::vector<StateVector, Eigen::aligned_allocator<StateVector> > predicted_states_; // Of each posterior from the one before
+    std::vector<CovarianceMatrix, Eigen::aligned_allocator<CovarianceMatrix> > predicted_covariances_;
+    std::vector<CovarianceMatrix, Eigen::aligned_allocator<CovarianceMatrix> > gains_; // D of the posterior before each
+    std::vector<bool> linked_; // Whether its gain is valid
+    size_t next_;
+    size_t count_;
+};
+
+#endif
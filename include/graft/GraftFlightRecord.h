@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_FLIGHT_RECORD_H
+#define GRAFT_FLIGHT_RECORD_H
+
+// Format of the flight recorder file written by the graft nodes when
+// 'flight_recorder_file' is set, and a header-only reader for it with no ROS
+// dependencies.  See graft_flight_decode for turning it into CSV or a bag.
+//
+// The file is a GraftFlightRecorderHeader followed by a ring of 'capacity'
+// bytes of records.  Each update writes a GRAFT_FLIGHT_MEASUREMENT record for
+// every measurement it used, then one GRAFT_FLIGHT_CYCLE record.  A record
+// that does not fit before the end of the ring starts over at its beginning,
+// overwriting the oldest records.  The magic of a record is stored last, so
+// one torn by a crash is never read.
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#define GRAFT_FLIGHT_RECORDER_MAGIC 0x47524652 // "GRFR"
+#define GRAFT_FLIGHT_RECORD_MAGIC 0x47524543 // "GREC"
+#define GRAFT_FLIGHT_RECORDER_VERSION 1
+#define GRAFT_FLIGHT_RECORDER_TOPICS 64 // Topics beyond these are not recorded
+#define GRAFT_FLIGHT_RECORDER_NAME 32
+
+struct GraftFlightRecorderHeader{
+  uint32_t magic;
+  uint32_t version;
+  uint64_t capacity; // Bytes of records after this header
+  uint64_t head; // Offset of the next record
+  uint64_t sequence; // Of the next record
+  uint32_t topics;
+  uint32_t reserved;
+  char process_model[GRAFT_FLIGHT_RECORDER_NAME];
+  char topic_names[GRAFT_FLIGHT_RECORDER_TOPICS][GRAFT_FLIGHT_RECORDER_NAME];
+};
+
+enum GraftFlightRecordType{
+  GRAFT_FLIGHT_MEASUREMENT = 1,
+  GRAFT_FLIGHT_CYCLE = 2
+};
+
+// Followed by the record of its type, size is a multiple of 8
+struct GraftFlightRecordHeader{
+  uint32_t magic;
+  uint32_t size; // Bytes including this header
+  uint64_t sequence;
+  uint32_t type;
+  uint32_t reserved;
+};
+
+// What z() of a topic returned, as in graft/GraftSensorResidual
+struct GraftFlightMeasurement{
+  uint32_t topic; // Index into the topic names
+  uint32_t reserved;
+  uint32_t stamp_sec;
+  uint32_t stamp_nsec;
+  double pose[7]; // x, y, z, qx, qy, qz, qw
+  double twist[6];
+  double accel[3];
+  double pose_covariance[36];
+  double twist_covariance[36];
+  double accel_covariance[9];
+};
+
+enum GraftFlightOutcome{
+  GRAFT_FLIGHT_UPDATED = 0,
+  GRAFT_FLIGHT_NO_MEASUREMENTS = 1, // The estimate did not change
+  GRAFT_FLIGHT_ALL_REJECTED = 2, // The prediction is the estimate
+  GRAFT_FLIGHT_RECOVERED = 3 // See graft/GraftRecoveryEvent
+};
+
+// Followed by size doubles of the posterior state and size*size of its covariance
+struct GraftFlightCycle{
+  uint32_t stamp_sec;
+  uint32_t stamp_nsec;
+  double dt;
+  uint64_t topics; // Bit per topic index, the topics of this update
+  uint64_t missing; // z() returned nothing: timed out, not received or invalid
+  uint64_t rejected; // By the innovation gate
+  uint32_t outcome;
+  uint32_t size; // 0 if the estimate did not change
+};
+
+inline bool graftFlightRecordBefore(const GraftFlightRecordHeader* a, const GraftFlightRecordHeader* b){
+  return a->sequence < b->sequence;
+}
+
+class GraftFlightRecorderReader{
+  public:
+    // Reads the whole file, false if it is not a flight recorder
+    bool open(const std::string& file){
+      std::ifstream in(file.c_str(), std::ios::binary);
+      if(!in){
+        return false;
+      }
+      data_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+      if(data_.size() < sizeof(GraftFlightRecorderHeader)){
+        return false;
+      }
+      const GraftFlightRecorderHeader& h = header();
+      return h.magic == GRAFT_FLIGHT_RECORDER_MAGIC && h.version == GRAFT_FLIGHT_RECORDER_VERSION &&
+             h.capacity <= data_.size() - sizeof(GraftFlightRecorderHeader);
+    }
+
+    const GraftFlightRecorderHeader& header() const{
+      return *reinterpret_cast<const GraftFlightRecorderHeader*>(&data_[0]);
+    }
+
+    std::string topicName(const uint32_t topic) const{
+      if(topic >= GRAFT_FLIGHT_RECORDER_TOPICS){
+        return "";
+      }
+      const char* name = header().topic_names[topic];
+      return std::string(name, strnlen(name, GRAFT_FLIGHT_RECORDER_NAME));
+    }
+
+    // Every complete record in the ring, oldest first.  Records are scanned
+    // in steps of 8 bytes past the remains of partly overwritten ones.
+    void records(std::vector<const GraftFlightRecordHeader*>& out) const{
+      out.clear();
+      const GraftFlightRecorderHeader& h = header();
+      const char* ring = &data_[sizeof(GraftFlightRecorderHeader)];
+      uint64_t offset = 0;
+      while(offset + sizeof(GraftFlightRecordHeader) <= h.capacity){
+        const GraftFlightRecordHeader* record = reinterpret_cast<const GraftFlightRecordHeader*>(ring + offset);
+        if(valid(*record, h.capacity - offset, h.sequence)){
+          out.push_back(record);
+          offset += record->size;
+        } else {
+          offset += 8;
+        }
+      }
+      std::sort(out.begin(), out.end(), graftFlightRecordBefore);
+    }
+
+    static const GraftFlightMeasurement& measurement(const GraftFlightRecordHeader* record){
+      return *reinterpret_cast<const GraftFlightMeasurement*>(record + 1);
+    }
+
+    static const GraftFlightCycle& cycle(const GraftFlightRecordHeader* record){
+      return *reinterpret_cast<const GraftFlightCycle*>(record + 1);
+    }
+
+    static const double* state(const GraftFlightRecordHeader* record){
+      return reinterpret_cast<const double*>(&cycle(record) + 1);
+    }
+
+    static const double* covariance(const GraftFlightRecordHeader* record){
+      return state(record) + cycle(record).size;
+    }
+
+  private:
+    static bool valid(const GraftFlightRecordHeader& record, const uint64_t space, const uint64_t sequence){
+      if(record.magic != GRAFT_FLIGHT_RECORD_MAGIC || record.size % 8 != 0 || record.size > space || record.sequence >= sequence){
+        return false;
+      }
+      uint64_t body = record.size - sizeof(GraftFlightRecordHeader);
+      if(record.type == GRAFT_FLIGHT_MEASUREMENT){
+        return body == sizeof(GraftFlightMeasurement);
+      }
+      if(record.type == GRAFT_FLIGHT_CYCLE && body >= sizeof(GraftFlightCycle)){
+        uint64_t n = reinterpret_cast<const GraftFlightCycle*>(&record + 1)->size;
+        return body == sizeof(GraftFlightCycle) + (n + n*n)*sizeof(double);
+      }
+      return false;
+    }
+
+    std::vector<char> data_;
+};
+
+#endif
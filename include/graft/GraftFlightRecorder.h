@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_FLIGHT_RECORDER_H
+#define GRAFT_FLIGHT_RECORDER_H
+
+// Writes what each update saw into a memory mapped ring, see
+// graft/GraftFlightRecord.h for the format.  Records are copied field by
+// field into the mapping, so writing makes no system calls and allocates
+// nothing.  The kernel writes the pages back to the file, which outlives the
+// process, and a restart with the same topics continues the ring.
+
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include <boost/shared_ptr.hpp>
+#include <graft/GraftFlightRecord.h>
+#include <graft/GraftScalar.h>
+#include <graft/GraftSensor.h>
+
+class GraftFlightRecorder{
+  public:
+    GraftFlightRecorder();
+
+    ~GraftFlightRecorder();
+
+    // Maps a ring of capacity bytes, creating the file if needed
+    bool open(const std::string& path, const size_t capacity, const std::string& process_model,
+              const std::vector<boost::shared_ptr<GraftSensor> >& topics);
+
+    void close();
+
+    bool isOpen();
+
+    void writeMeasurement(const uint32_t topic, const graft::GraftSensorResidual& z);
+
+    // state and covariance are column-major, NULL with size 0 if the estimate did not change
+    void writeCycle(const GraftFlightCycle& cycle, const GraftScalar* state, const GraftScalar* covariance);
+
+  private:
+    // Space for a record of body bytes, invalid until commit, NULL if it can never fit
+    GraftFlightRecordHeader* reserve(const uint32_t type, const size_t body);
+
+    void commit(GraftFlightRecordHeader* record);
+
+    std::string path_;
+    size_t size_; // Of the mapping
+    GraftFlightRecorderHeader* header_;
+    char* ring_;
+};
+
+#endif
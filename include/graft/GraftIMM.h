@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_IMM_H
+#define GRAFT_IMM_H
+
+#include <string>
+#include <vector>
+#include <boost/thread.hpp>
+#include <Eigen/Dense>
+#include <Eigen/StdVector>
+
+#include <graft/GraftFilter.h>
+#include <graft/GraftUKF.h>
+
+// A mode of GraftIMM, the process noise its filter runs with
+struct GraftIMMMode{
+  std::string name;
+  std::vector<double> process_noise;
+  double probability; // Initial, normalized over the modes
+};
+
+// Interacting multiple model filter: one GraftUKF of ProcessModel per mode,
+// each with its own process noise, so a quiet and a maneuvering model can
+// run side by side.  Each update
+//
+//   mixes     the mode estimates by the probability of switching between
+//             modes since the last update, a Markov chain that stays in a
+//             mode with stay_probability and otherwise switches to any other
+//   updates   each mode from the same measurements, read once, on its own
+//             worker thread if there are cores for it; the gate statistics
+//             count the tests of the mode predicted most probable
+//   weighs    the modes by the likelihood of those measurements under each
+//   combines  the mode estimates into the one published
+//
+// Instantiated for each model in GraftIMM.cpp.
+template<class ProcessModel>
+class GraftIMM : public GraftFilter{
+  public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    enum { SIZE = ProcessModel::SIZE };
+
+    typedef GraftUKF<ProcessModel> Mode;
+    typedef typename Mode::StateVector StateVector;
+    typedef typename Mode::CovarianceMatrix CovarianceMatrix;
+
+    // Updates the modes on worker threads if threads is set and there is more than one core
+    GraftIMM(const std::vector<GraftIMMMode>& modes, const double stay_probability, const bool threads);
+
+    ~GraftIMM();
+
+    graft::GraftStatePtr getMessageFromState();
+
+    graft::GraftStateCompactPtr getCompactMessageFromState();
+
+    graft::GraftStatePtr getMessageAtTime(const ros::Time& stamp);
+
+    void getMessageFromState(graft::GraftState& msg);
+
+    void getCompactMessageFromState(graft::GraftStateCompact& msg);
+
+    bool getMessageAtTime(const ros::Time& stamp, graft::GraftState& msg);
+
+    ros::Time getStateTime();
+
+    double predictAndUpdate();
+
+    double predictAndUpdate(std::vector<boost::shared_ptr<GraftSensor> >& topics);
+
+    void setTopics(std::vector<boost::shared_ptr<GraftSensor> >& topics);
+
+    void setInitialCovariance(std::vector<double>& P);
+
+    // Only of the combined estimate, the modes keep their own
+    void setProcessNoise(std::vector<double>& Q);
+
+    // Q[i] of the i-th mode, as in the modes passed to the constructor
+    void setModeProcessNoise(std::vector<std::vector<double> >& Q);
+
+    void setAlpha(const double alpha);
+
+    void setKappa(const double kappa);
+
+    void setBeta(const double beta);
+
+    void setStateHistorySize(const size_t size);
+
+    void setInitializeFromMeasurements(const bool initialize, const double timeout);
+
+    bool isReady();
+
+    void setRecovery(const double inflation, const int max_recoveries);
+
+    void setRecoveryCallback(RecoveryFunction callback);
+
+    void setMeanOnlyPrediction(const bool mean_only);
+
+    // Not supported, the modes would record the same updates over each other
+    void setFlightRecorder(GraftFlightRecorder* recorder);
+
+    // Not supported, the combined estimate has no single prediction to smooth through
+    void setSmootherLag(const size_t lag);
+
+    bool getSmoothedMessage(graft::GraftState& msg);
+
+    bool getPosterior(std::vector<double>& state, std::vector<double>& covariance);
+
+    // Restores every mode to the posterior
+    bool restorePosterior(const ros::Time& stamp, const std::vector<double>& state, const std::vector<double>& covariance);
+
+    size_t size();
+
+    void updateOdometry(const graft::GraftState& state, const double dt, nav_msgs::Odometry& odom);
+
+    // Of each mode, in the order they were configured
+    const std::vector<double>& getModeProbabilities() const{
+      return probabilities_;
+    }
+
+  private:
+    typedef std::vector<StateVector, Eigen::aligned_allocator<StateVector> > StateVectors;
+
+    // Replaces each mode estimate with its mix of all of them
+    void mix();
+
+    // Moment matched mixture of the mode estimates weighted by weights
+    void combine(const std::vector<double>& weights, StateVector& state, CovarianceMatrix& covariance);
+
+    // Mode probabilities from the likelihood of the last update under each
+    void updateProbabilities();
+
+    void updateMode(const size_t i);
+
+    // Of each worker, updates its mode each cycle
+    void work(const size_t i);
+
+    std::vector<boost::shared_ptr<Mode> > modes_;
+    std::vector<std::string> names_;
+    size_t most_probable_; // Mode, logged when it changes
+    Eigen::MatrixXd transition_; // (i,j) is the probability of switching from mode i to j
+    std::vector<double> probabilities_;
+    std::vector<double> predicted_probabilities_; // After the switch, before the update
+    std::vector<double> mixing_weights_; // Of each mode in the mix of one
+    std::vector<double> log_likelihoods_;
+    StateVectors mixed_states_;
+    std::vector<CovarianceMatrix, Eigen::aligned_allocator<CovarianceMatrix> > mixed_covariances_;
+    bool mixed_; // No mode updated since the last mix
+
+    Mode combined_; // Holds the published estimate and its history
+
+    std::vector<boost::shared_ptr<GraftSensor> > topics_;
+
+    // Of the current update, shared with the workers
+    std::vector<boost::shared_ptr<GraftSensor> >* cycle_topics_;
+    typename Mode::Measurements z_;
+    ros::Time t_;
+    std::vector<double> dts_;
+    std::vector<char> consumed_;
+
+    boost::mutex gate_mutex_; // The modes test the same gates
+
+    // Modes 1 and on are updated by workers, mode 0 on the calling thread
+    boost::thread_group workers_;
+    boost::mutex work_mutex_;
+    boost::condition_variable work_started_;
+    boost::condition_variable work_done_;
+    unsigned long cycle_;
+    size_t pending_; // Workers still updating this cycle
+};
+
+// Of process_model, see createGraftFilter, returns NULL for other names
+boost::shared_ptr<GraftFilter> createGraftIMM(const std::string& process_model, const std::vector<GraftIMMMode>& modes, const double stay_probability, const bool threads);
+
+#endif
@@ -35,6 +35,7 @@
 #define GRAFT_IMU_TOPIC_H
 
 #include <graft/GraftSensor.h>
+#include <graft/GraftSensorExtrinsics.h>
 #include <ros/ros.h>
 #include <Eigen/Dense>
 #include <sensor_msgs/Imu.h>
@@ -51,7 +52,15 @@ class GraftImuTopic: public GraftSensor {
 
   	void callback(const sensor_msgs::Imu::ConstPtr& msg);
 
-    virtual graft::GraftSensorResidual::Ptr h(const graft::GraftState& state);
+    virtual void configure(ros::NodeHandle& tnh);
+
+    virtual void stageTuning(ros::NodeHandle& tnh);
+
+    virtual void commitTuning();
+
+    virtual ros::Subscriber subscribe(ros::NodeHandle& n, const std::string& topic, const uint32_t queue_size);
+
+    virtual void h(const graft::GraftState& state, graft::GraftSensorResidual& out);
 
     virtual graft::GraftSensorResidual::Ptr z();
 
@@ -61,6 +70,10 @@ class GraftImuTopic: public GraftSensor {
 
     virtual void clearMessage();
 
+    virtual bool getDeltaMemory(ros::Time& stamp, geometry_msgs::Pose& pose);
+
+    virtual void setDeltaMemory(const ros::Time& stamp, const geometry_msgs::Pose& pose);
+
     //virtual MatrixXd H(graft::GraftState& state);
 
     //virtual MatrixXd y(graft::GraftState& predicted);
@@ -82,6 +95,8 @@ class GraftImuTopic: public GraftSensor {
     void setAngularVelocityCovariance(boost::array<double, 9>& cov);
 
     void setLinearAccelerationCovariance(boost::array<double, 9>& cov);
+
+    virtual void setExtrinsics(const GraftSensorExtrinsics& extrinsics);
     
   private:
 
@@ -102,6 +117,14 @@ class GraftImuTopic: public GraftSensor {
   	boost::array<double, 9> angular_velocity_covariance_;
     boost::array<double, 9> linear_acceleration_covariance_;
 
+    // Read by stageTuning, applied by commitTuning
+    double staged_timeout_;
+    boost::array<double, 9> staged_orientation_covariance_;
+    boost::array<double, 9> staged_angular_velocity_covariance_;
+    boost::array<double, 9> staged_linear_acceleration_covariance_;
+
+    GraftSensorExtrinsics extrinsics_; // header.frame_id -> base frame
+
 };
 
 #endif
\ No newline at end of file
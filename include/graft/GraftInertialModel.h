@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_INERTIAL_MODEL_H
+#define GRAFT_INERTIAL_MODEL_H
+
+#include <cmath>
+#include <Eigen/Dense>
+#include <graft/GraftScalar.h>
+#include <graft/GraftState.h>
+#include <graft/GraftMeasurementSet.h>
+#include <graft/GraftInitialization.h>
+#include <nav_msgs/Odometry.h>
+#include <tf/transform_datatypes.h>
+
+// x, y, z, roll, pitch, yaw, vx, vy, vz, wx, wy, wz, gyro bias x, y, z, accel bias x, y, z
+struct GraftInertialModel{
+  enum { SIZE = 18 };
+  typedef Eigen::Matrix<GraftScalar, SIZE, 1> StateVector;
+
+  static const char* name(){
+    return "inertial";
+  }
+
+  static void initialState(StateVector& x){
+    x.setZero();
+  }
+
+  static unsigned int requiredInitialization(){
+    return GRAFT_INIT_POSITION | GRAFT_INIT_ORIENTATION | GRAFT_INIT_LINEAR_VELOCITY;
+  }
+
+  // Seeds the state from one measurement, returns the GraftInitialization parts it set.
+  // IMU rates and accelerations include the biases, so they are not seeded.
+  template<typename Covariance>
+  static unsigned int initialize(const graft::GraftSensorResidual& meas, StateVector& x, Covariance& P){
+    unsigned int seeded = 0;
+    double position[3] = {meas.pose.position.x, meas.pose.position.y, meas.pose.position.z};
+    double linear[3] = {meas.twist.linear.x, meas.twist.linear.y, meas.twist.linear.z};
+    for(int k = 0; k < 3; k++){
+      if(meas.pose_covariance[7*k] > 1e-20){
+        seedElement(x, P, k, position[k], meas.pose_covariance[7*k]);
+        seeded |= GRAFT_INIT_POSITION;
+      }
+      if(meas.twist_covariance[7*k] > 1e-20){
+        seedElement(x, P, 6 + k, linear[k], meas.twist_covariance[7*k]);
+        seeded |= GRAFT_INIT_LINEAR_VELOCITY;
+      }
+    }
+    double rpy[3];
+    if(meas.pose_covariance[21] > 1e-20 || meas.pose_covariance[28] > 1e-20 || meas.pose_covariance[35] > 1e-20){
+      rpyFromQuaternion(meas.pose.orientation, rpy[0], rpy[1], rpy[2]);
+      for(int k = 0; k < 3; k++){
+        if(meas.pose_covariance[21+7*k] > 1e-20){
+          seedElement(x, P, 3 + k, rpy[k], meas.pose_covariance[21+7*k]);
+        }
+      }
+      seeded |= GRAFT_INIT_ORIENTATION;
+    } else if(meas.accel_covariance[0] > 1e-20 && meas.accel_covariance[4] > 1e-20 && meas.accel_covariance[8] > 1e-20
+              && rollPitchFromAcceleration(meas.accel, rpy[0], rpy[1])){ // Level from gravity, yaw stays zero
+      x(3) = rpy[0];
+      x(4) = rpy[1];
+      seeded |= GRAFT_INIT_ORIENTATION;
+    }
+    return seeded;
+  }
+
+  // Constant body velocity and rate, random walk biases
+  static StateVector f(const StateVector& x, const double dt){
+    StateVector out = x;
+    double roll = x(3);
+    double pitch = x(4);
+    Eigen::Vector3d v = x.block<3, 1>(6, 0).cast<double>();
+    Eigen::Vector3d w = x.block<3, 1>(9, 0).cast<double>();
+    out.block<3, 1>(0, 0) += (rotationFromRPY(roll, pitch, x(5))*v*dt).cast<GraftScalar>();
+    // Euler angle rates from body rates, singular at pitch = +-pi/2
+    double cos_pitch = std::cos(pitch);
+    if(std::abs(cos_pitch) < 1e-6){
+      cos_pitch = cos_pitch < 0 ? -1e-6 : 1e-6;
+    }
+    double tan_pitch = std::sin(pitch)/cos_pitch;
+    out(3) += (w(0) + std::sin(roll)*tan_pitch*w(1) + std::cos(roll)*tan_pitch*w(2))*dt;
+    out(4) += (std::cos(roll)*w(1) - std::sin(roll)*w(2))*dt;
+    out(5) += (std::sin(roll)/cos_pitch*w(1) + std::cos(roll)/cos_pitch*w(2))*dt;
+    return out;
+  }
+
+  static StateVector extrapolate(const StateVector& x, const double dt){
+    return f(x, dt);
+  }
+
+  // Angles are kept continuous so sigma points never wrap
+  static void normalize(StateVector& x){
+  }
+
+  // Longest prediction step, 0 for no limit
+  static double maxTimeStep(){
+    return 0.0;
+  }
+
+  static void toMessage(const StateVector& x, graft::GraftState& msg){
+    msg.pose.position.x = x(0);
+    msg.pose.position.y = x(1);
+    msg.pose.position.z = x(2);
+    msg.pose.orientation = tf::createQuaternionMsgFromRollPitchYaw(x(3), x(4), x(5));
+    msg.twist.linear.x = x(6);
+    msg.twist.linear.y = x(7);
+    msg.twist.linear.z = x(8);
+    msg.twist.angular.x = x(9);
+    msg.twist.angular.y = x(10);
+    msg.twist.angular.z = x(11);
+    // Body frame acceleration of a constant body velocity on a rotating frame
+    Eigen::Vector3d acceleration = x.block<3, 1>(9, 0).cross(x.block<3, 1>(6, 0)).cast<double>();
+    msg.acceleration.x = acceleration(0);
+    msg.acceleration.y = acceleration(1);
+    msg.acceleration.z = acceleration(2);
+    msg.gyro_bias.x = x(12);
+    msg.gyro_bias.y = x(13);
+    msg.gyro_bias.z = x(14);
+    msg.accel_bias.x = x(15);
+    msg.accel_bias.y = x(16);
+    msg.accel_bias.z = x(17);
+  }
+
+  static void addMeasurements(const graft::GraftSensorResidual& meas, const GraftMeasurementSet::Residuals& residuals, GraftMeasurementSet& measurements){
+    // Position
+    if(meas.pose_covariance[0] > 1e-20){
+      measurements.add(meas, meas.pose_covariance[0], residuals, residualPositionX);
+    }
+    if(meas.pose_covariance[7] > 1e-20){
+      measurements.add(meas, meas.pose_covariance[7], residuals, residualPositionY);
+    }
+    if(meas.pose_covariance[14] > 1e-20){
+      measurements.add(meas, meas.pose_covariance[14], residuals, residualPositionZ);
+    }
+
+    // Orientation, compared as roll, pitch and yaw
+    if(meas.pose_covariance[21] > 1e-20){
+      measurements.addAngle(meas, meas.pose_covariance[21], residuals, residualRoll);
+    }
+    if(meas.pose_covariance[28] > 1e-20){
+      measurements.addAngle(meas, meas.pose_covariance[28], residuals, residualPitch);
+    }
+    if(meas.pose_covariance[35] > 1e-20){
+      measurements.addAngle(meas, meas.pose_covariance[35], residuals, residualYaw);
+    }
+
+    // Linear velocity
+    if(meas.twist_covariance[0] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[0], residuals, residualLinearVelocityX);
+    }
+    if(meas.twist_covariance[7] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[7], residuals, residualLinearVelocityY);
+    }
+    if(meas.twist_covariance[14] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[14], residuals, residualLinearVelocityZ);
+    }
+
+    // Angular velocity, includes the gyro bias for IMUs
+    if(meas.twist_covariance[21] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[21], residuals, residualAngularVelocityX);
+    }
+    if(meas.twist_covariance[28] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[28], residuals, residualAngularVelocityY);
+    }
+    if(meas.twist_covariance[35] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[35], residuals, residualAngularVelocityZ);
+    }
+
+    // Linear acceleration, includes gravity and the accelerometer bias for IMUs
+    if(meas.accel_covariance[0] > 1e-20){
+      measurements.add(meas, meas.accel_covariance[0], residuals, residualAccelX);
+    }
+    if(meas.accel_covariance[4] > 1e-20){
+      measurements.add(meas, meas.accel_covariance[4], residuals, residualAccelY);
+    }
+    if(meas.accel_covariance[8] > 1e-20){
+      measurements.add(meas, meas.accel_covariance[8], residuals, residualAccelZ);
+    }
+  }
+
+  static void toOdometry(const graft::GraftState& state, const double dt, nav_msgs::Odometry& odom){
+    odom.pose.pose = state.pose;
+    odom.twist.twist = state.twist;
+  }
+
+  static Eigen::Matrix3d rotationFromRPY(const double roll, const double pitch, const double yaw){
+    Eigen::Matrix3d out;
+    out = Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitZ())
+        * Eigen::AngleAxisd(pitch, Eigen::Vector3d::UnitY())
+        * Eigen::AngleAxisd(roll, Eigen::Vector3d::UnitX());
+    return out;
+  }
+
+  static double residualRoll(const graft::GraftSensorResidual& r){
+    double roll, pitch, yaw;
+    rpyFromQuaternion(r.pose.orientation, roll, pitch, yaw);
+    return roll;
+  }
+
+  static double residualPitch(const graft::GraftSensorResidual& r){
+    double roll, pitch, yaw;
+    rpyFromQuaternion(r.pose.orientation, roll, pitch, yaw);
+    return pitch;
+  }
+
+  static double residualYaw(const graft::GraftSensorResidual& r){
+    double roll, pitch, yaw;
+    rpyFromQuaternion(r.pose.orientation, roll, pitch, yaw);
+    return yaw;
+  }
+
+  static void rpyFromQuaternion(const geometry_msgs::Quaternion& q, double& roll, double& pitch, double& yaw){
+    tf::Quaternion tfq;
+    tf::quaternionMsgToTF(q, tfq);
+    tf::Matrix3x3(tfq).getRPY(roll, pitch, yaw);
+  }
+};
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_INITIALIZATION_H
+#define GRAFT_INITIALIZATION_H
+
+#include <algorithm>
+#include <cmath>
+#include <Eigen/Dense>
+#include <boost/array.hpp>
+#include <geometry_msgs/Quaternion.h>
+#include <geometry_msgs/Vector3.h>
+#include <graft/GraftQuaternion.h>
+
+// Parts of the state a process model seeds directly from measurements, see
+// initialize() in the process models.
+enum GraftInitialization{
+  GRAFT_INIT_POSITION = 1,
+  GRAFT_INIT_ORIENTATION = 2,
+  GRAFT_INIT_LINEAR_VELOCITY = 4,
+  GRAFT_INIT_ANGULAR_VELOCITY = 8
+};
+
+// Sets one state element and its variance, dropping any prior correlation
+template<typename State, typename Covariance>
+void seedElement(State& x, Covariance& P, const int index, const double value, const double variance){
+  x(index) = value;
+  P.row(index).setZero();
+  P.col(index).setZero();
+  P(index, index) = variance;
+}
+
+// Sets a w, x, y, z quaternion at index from a measured orientation, with the
+// variances implied by its roll, pitch and yaw covariance
+template<typename State, typename Covariance>
+bool seedQuaternion(State& x, Covariance& P, const int index, const geometry_msgs::Quaternion& q, const boost::array<double, 36>& pose_covariance){
+  double norm = std::sqrt(q.w*q.w + q.x*q.x + q.y*q.y + q.z*q.z);
+  if(norm < 1e-10){
+    return false;
+  }
+  Eigen::Matrix<GraftScalar, 4, 1> cov = quaternionCovFromEuler(pose_covariance[21], pose_covariance[28], pose_covariance[35],
+                                                                q.x, q.y, q.z, q.w); // x, y, z, w
+  double values[4] = {q.w/norm, q.x/norm, q.y/norm, q.z/norm};
+  double variances[4] = {cov(3), cov(0), cov(1), cov(2)};
+  for(int k = 0; k < 4; k++){
+    if(std::isfinite(variances[k])){
+      seedElement(x, P, index + k, values[k], std::max(variances[k], 1e-12));
+    } else {
+      x(index + k) = values[k];
+    }
+  }
+  return true;
+}
+
+// Roll and pitch from the direction of gravity in a measured specific force
+inline bool rollPitchFromAcceleration(const geometry_msgs::Vector3& accel, double& roll, double& pitch){
+  double norm = std::sqrt(accel.x*accel.x + accel.y*accel.y + accel.z*accel.z);
+  if(norm < 1e-3){
+    return false;
+  }
+  roll = std::atan2(accel.y, accel.z);
+  pitch = std::atan2(-accel.x, std::sqrt(accel.y*accel.y + accel.z*accel.z));
+  return true;
+}
+
+#endif
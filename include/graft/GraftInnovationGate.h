@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_INNOVATION_GATE_H
+#define GRAFT_INNOVATION_GATE_H
+
+#include <stdint.h>
+#include <vector>
+#include <limits>
+#include <boost/math/distributions/chi_squared.hpp>
+
+// Chi-square test of a topic's normalized innovation squared, the squared
+// Mahalanobis distance of its measurement from the prediction, with counts
+// of the measurements it accepted and rejected.
+class GraftInnovationGate{
+  public:
+    GraftInnovationGate(): probability_(0.0), accepted_(0), rejected_(0), last_nis_(0.0){}
+
+    // Measurements beyond this quantile of the chi-square distribution are
+    // rejected, 0 accepts everything
+    void setProbability(const double probability){
+      probability_ = probability;
+      thresholds_.clear();
+    }
+
+    double getProbability() const{
+      return probability_;
+    }
+
+    // Records the test of a measurement with dof elements, false if it is rejected
+    bool test(const double nis, const size_t dof){
+      last_nis_ = nis;
+      if(accepts(nis, dof)){
+        accepted_++;
+        return true;
+      }
+      rejected_++;
+      return false;
+    }
+
+    // The same test, not recorded
+    bool accepts(const double nis, const size_t dof){
+      return probability_ <= 0.0 || nis <= threshold(dof); // NaN is rejected when gating
+    }
+
+    double threshold(const size_t dof){
+      if(probability_ <= 0.0 || dof == 0){
+        return std::numeric_limits<double>::infinity();
+      }
+      if(dof >= thresholds_.size()){
+        thresholds_.resize(dof + 1, -1.0);
+      }
+      if(thresholds_[dof] < 0.0){
+        thresholds_[dof] = boost::math::quantile(boost::math::chi_squared(dof), probability_);
+      }
+      return thresholds_[dof];
+    }
+
+    uint32_t getAccepted() const{
+      return accepted_;
+    }
+
+    uint32_t getRejected() const{
+      return rejected_;
+    }
+
+    // Of the latest measurement tested
+    double getLastNIS() const{
+      return last_nis_;
+    }
+
+  private:
+    double probability_;
+    std::vector<double> thresholds_; // By degrees of freedom, computed on first use
+    uint32_t accepted_;
+    uint32_t rejected_;
+    double last_nis_;
+};
+
+#endif
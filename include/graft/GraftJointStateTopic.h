@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_JOINT_STATE_TOPIC_H
+#define GRAFT_JOINT_STATE_TOPIC_H
+
+#include <graft/GraftOdometryTopic.h>
+#include <sensor_msgs/JointState.h>
+
+// sensor_msgs/JointState from wheel encoders, fused as the body twist of a
+// differential drive or skid steer base.  'left_wheels' and 'right_wheels'
+// name the joints on each side, which are averaged.  Forward velocity is
+// wheel_radius*(left + right)/2 and yaw rate is
+// wheel_radius*(right - left)/(track*track_multiplier), where a
+// track_multiplier above 1 accounts for skid steer slip.  Joint velocities
+// are used when present, otherwise joint positions are differentiated.
+// 'wheel_velocity_variance' is the variance of one wheel in rad^2/s^2 and is
+// propagated into the twist covariance; 'lateral_velocity_variance' above 0
+// also fuses the no side slip constraint.  Uses the Odometry parameters, and
+// 'sensor_frame_id' for the axle center with lookup_extrinsics.
+class GraftJointStateTopic: public GraftOdometryTopic {
+  public:
+    GraftJointStateTopic();
+
+    ~GraftJointStateTopic();
+
+    void jointStateCallback(const sensor_msgs::JointState::ConstPtr& msg);
+
+    virtual void configure(ros::NodeHandle& tnh);
+
+    virtual void stageTuning(ros::NodeHandle& tnh);
+
+    virtual void commitTuning();
+
+    virtual ros::Subscriber subscribe(ros::NodeHandle& n, const std::string& topic, const uint32_t queue_size);
+
+  private:
+    // Finds the joints once and again only if the message order changes
+    bool lookupJoints(const sensor_msgs::JointState& msg, const std::vector<std::string>& names, std::vector<size_t>& indices);
+
+    // Mean wheel velocity of one side in rad/s
+    bool sideVelocity(const sensor_msgs::JointState& msg, const std::vector<size_t>& indices, double dt, double& velocity);
+
+    std::vector<std::string> left_wheels_;
+    std::vector<std::string> right_wheels_;
+    std::vector<size_t> left_indices_;
+    std::vector<size_t> right_indices_;
+    sensor_msgs::JointState::ConstPtr last_msg_; // Used when differentiating positions
+
+    double wheel_radius_;
+    double track_;
+    double track_multiplier_;
+    double wheel_velocity_variance_;
+    double lateral_velocity_variance_;
+    double staged_wheel_velocity_variance_; // Read by stageTuning, applied by commitTuning
+    double staged_lateral_velocity_variance_;
+    std::string sensor_frame_id_;
+};
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_LOAD_SHEDDER_H
+#define GRAFT_LOAD_SHEDDER_H
+
+#include <stdint.h>
+#include <graft/GraftLoadShedding.h>
+
+// Degradation level from the time each update takes against a deadline.  An
+// update over the deadline moves one level up, see GraftLoadShedding.msg,
+// and RECOVERY_CYCLES updates in a row under half of it move one level down.
+class GraftLoadShedder{
+  public:
+    enum { RECOVERY_CYCLES = 20 };
+
+    GraftLoadShedder(): deadline_(0.0), level_(graft::GraftLoadShedding::NOMINAL), under_(0){}
+
+    // Seconds allowed for each update, 0 never sheds load
+    void setDeadline(const double deadline){
+      deadline_ = deadline;
+      if(deadline_ <= 0.0){
+        level_ = graft::GraftLoadShedding::NOMINAL;
+        under_ = 0;
+      }
+    }
+
+    double getDeadline() const{
+      return deadline_;
+    }
+
+    // Records the seconds an update took, true if the level changed
+    bool addCycle(const double seconds){
+      if(deadline_ <= 0.0){
+        return false;
+      }
+      if(seconds > deadline_){
+        under_ = 0;
+        if(level_ < graft::GraftLoadShedding::MEAN_ONLY){
+          level_++;
+          return true;
+        }
+        return false;
+      }
+      if(level_ == graft::GraftLoadShedding::NOMINAL || seconds > 0.5*deadline_){
+        under_ = 0;
+        return false;
+      }
+      if(++under_ < RECOVERY_CYCLES){
+        return false;
+      }
+      under_ = 0;
+      level_--;
+      return true;
+    }
+
+    uint8_t getLevel() const{
+      return level_;
+    }
+
+  private:
+    double deadline_;
+    uint8_t level_;
+    int under_; // Updates in a row under half of the deadline
+};
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_MEASUREMENT_SET_H
+#define GRAFT_MEASUREMENT_SET_H
+
+#include <graft/GraftScalar.h>
+#include <graft/GraftSensorResidual.h>
+#include <cmath>
+#include <vector>
+
+// Rows a topic adds at most, one for each field of a residual below
+#define GRAFT_MAX_TOPIC_ROWS 16
+
+// Measurement vector assembled element by element from each topic, along
+// with the same element predicted by h() for every sigma point.
+class GraftMeasurementSet{
+  public:
+    typedef double (*Field)(const graft::GraftSensorResidual& residual);
+
+    // h() of every sigma point, owned by the filter and filled in place
+    typedef std::vector<graft::GraftSensorResidual> Residuals;
+
+    GraftMeasurementSet(): columns_(0){}
+
+    void clear(){
+      z_.clear();
+      noise_.clear();
+      predicted_.clear();
+    }
+
+    size_t size() const{
+      return z_.size();
+    }
+
+    void add(const graft::GraftSensorResidual& meas, const double variance, const Residuals& predicted, Field field){
+      columns_ = predicted.size();
+      z_.push_back(field(meas));
+      noise_.push_back(variance);
+      for(size_t i = 0; i < predicted.size(); i++){
+        predicted_.push_back(field(predicted[i]));
+      }
+    }
+
+    // Angles are expressed relative to the measurement so the sigma points never straddle +-pi
+    void addAngle(const graft::GraftSensorResidual& meas, const double variance, const Residuals& predicted, Field field){
+      columns_ = predicted.size();
+      double measured = field(meas);
+      z_.push_back(measured);
+      noise_.push_back(variance);
+      for(size_t i = 0; i < predicted.size(); i++){
+        double diff = field(predicted[i]) - measured;
+        predicted_.push_back(measured + std::atan2(std::sin(diff), std::cos(diff)));
+      }
+    }
+
+    // Removes elements [begin, end)
+    void erase(const size_t begin, const size_t end){
+      z_.erase(z_.begin() + begin, z_.begin() + end);
+      noise_.erase(noise_.begin() + begin, noise_.begin() + end);
+      predicted_.erase(predicted_.begin() + begin*columns_, predicted_.begin() + end*columns_);
+    }
+
+    void get(GraftVector& z, GraftVector& noise, GraftMatrix& sigma_points) const{
+      z.resize(z_.size());
+      noise.resize(z_.size());
+      sigma_points.resize(z_.size(), columns_);
+      for(size_t i = 0; i < z_.size(); i++){
+        z(i) = z_[i];
+        noise(i) = noise_[i];
+        for(size_t j = 0; j < columns_; j++){
+          sigma_points(i, j) = predicted_[i*columns_ + j];
+        }
+      }
+    }
+
+  private:
+    std::vector<double> z_;
+    std::vector<double> noise_;
+    std::vector<double> predicted_; // Row-major, one row per element
+    size_t columns_;
+};
+
+// Fields of a residual, for GraftMeasurementSet::add
+inline double residualPositionX(const graft::GraftSensorResidual& r){ return r.pose.position.x; }
+inline double residualPositionY(const graft::GraftSensorResidual& r){ return r.pose.position.y; }
+inline double residualPositionZ(const graft::GraftSensorResidual& r){ return r.pose.position.z; }
+inline double residualOrientationW(const graft::GraftSensorResidual& r){ return r.pose.orientation.w; }
+inline double residualOrientationX(const graft::GraftSensorResidual& r){ return r.pose.orientation.x; }
+inline double residualOrientationY(const graft::GraftSensorResidual& r){ return r.pose.orientation.y; }
+inline double residualOrientationZ(const graft::GraftSensorResidual& r){ return r.pose.orientation.z; }
+inline double residualLinearVelocityX(const graft::GraftSensorResidual& r){ return r.twist.linear.x; }
+inline double residualLinearVelocityY(const graft::GraftSensorResidual& r){ return r.twist.linear.y; }
+inline double residualLinearVelocityZ(const graft::GraftSensorResidual& r){ return r.twist.linear.z; }
+inline double residualAngularVelocityX(const graft::GraftSensorResidual& r){ return r.twist.angular.x; }
+inline double residualAngularVelocityY(const graft::GraftSensorResidual& r){ return r.twist.angular.y; }
+inline double residualAngularVelocityZ(const graft::GraftSensorResidual& r){ return r.twist.angular.z; }
+inline double residualAccelX(const graft::GraftSensorResidual& r){ return r.accel.x; }
+inline double residualAccelY(const graft::GraftSensorResidual& r){ return r.accel.y; }
+inline double residualAccelZ(const graft::GraftSensorResidual& r){ return r.accel.z; }
+
+#endif
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_NAV_SAT_FIX_TOPIC_H
+#define GRAFT_NAV_SAT_FIX_TOPIC_H
+
+#include <graft/GraftOdometryTopic.h>
+#include <sensor_msgs/NavSatFix.h>
+
+// sensor_msgs/NavSatFix, fused as an absolute position in a local East, North,
+// Up frame without a separate conversion node.  The frame is anchored at the
+// 'datum' parameter [latitude, longitude, altitude] or, if it is not set, at
+// the first fix.  Fixes are converted through WGS84 ECEF with the datum
+// rotation computed once.  The message covariance is used according to its
+// position_covariance_type, 'unknown_variance' replaces an unknown one, and
+// 'fix_inflation' scales it for fixes without SBAS or GBAS augmentation.
+// Without 'unknown_variance', fixes with COVARIANCE_TYPE_UNKNOWN are not fused.
+// Fixes with STATUS_NO_FIX are dropped.  Uses the Odometry parameters, and
+// 'sensor_frame_id' for the antenna with lookup_extrinsics.  The antenna
+// lever arm is applied to the predicted position along the estimated
+// orientation, since a fix carries none.
+class GraftNavSatFixTopic: public GraftOdometryTopic {
+  public:
+    GraftNavSatFixTopic();
+
+    ~GraftNavSatFixTopic();
+
+    void navSatFixCallback(const sensor_msgs::NavSatFix::ConstPtr& msg);
+
+    virtual void configure(ros::NodeHandle& tnh);
+
+    virtual void stageTuning(ros::NodeHandle& tnh);
+
+    virtual void commitTuning();
+
+    virtual ros::Subscriber subscribe(ros::NodeHandle& n, const std::string& topic, const uint32_t queue_size);
+
+    void setDatum(double latitude, double longitude, double altitude);
+
+  private:
+    Vector3d toECEF(double latitude, double longitude, double altitude);
+
+    bool has_datum_;
+    double datum_altitude_;
+    Vector3d datum_ecef_;
+    Matrix3d ecef_to_enu_;
+
+    double unknown_variance_;
+    double fix_inflation_;
+    double staged_unknown_variance_; // Read by stageTuning, applied by commitTuning
+    double staged_fix_inflation_;
+    bool warned_unknown_variance_; // Unknown covariance fixes without unknown_variance are warned about once
+    std::string sensor_frame_id_;
+};
+
+#endif
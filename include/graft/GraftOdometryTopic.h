@@ -35,6 +35,7 @@
 #define GRAFT_ODOMETRY_TOPIC_H
 
 #include <graft/GraftSensor.h>
+#include <graft/GraftSensorExtrinsics.h>
 #include <ros/ros.h>
 #include <Eigen/Dense>
 #include <nav_msgs/Odometry.h>
@@ -51,7 +52,15 @@ class GraftOdometryTopic: public GraftSensor {
 
   	void callback(const nav_msgs::Odometry::ConstPtr& msg);
 
-    virtual graft::GraftSensorResidual::Ptr h(const graft::GraftState& state);
+    virtual void configure(ros::NodeHandle& tnh);
+
+    virtual void stageTuning(ros::NodeHandle& tnh);
+
+    virtual void commitTuning();
+
+    virtual ros::Subscriber subscribe(ros::NodeHandle& n, const std::string& topic, const uint32_t queue_size);
+
+    virtual void h(const graft::GraftState& state, graft::GraftSensorResidual& out);
 
     virtual graft::GraftSensorResidual::Ptr z();
 
@@ -61,6 +70,10 @@ class GraftOdometryTopic: public GraftSensor {
 
     virtual void clearMessage();
 
+    virtual bool getDeltaMemory(ros::Time& stamp, geometry_msgs::Pose& pose);
+
+    virtual void setDeltaMemory(const ros::Time& stamp, const geometry_msgs::Pose& pose);
+
     //virtual MatrixXd H(graft::GraftState& state);
 
     //virtual MatrixXd y(graft::GraftState& predicted);
@@ -79,6 +92,8 @@ class GraftOdometryTopic: public GraftSensor {
     void setPoseCovariance(boost::array<double, 36>& cov);
 
     void setTwistCovariance(boost::array<double, 36>& cov);
+
+    virtual void setExtrinsics(const GraftSensorExtrinsics& extrinsics);
     
   private:
 
@@ -93,11 +108,19 @@ class GraftOdometryTopic: public GraftSensor {
   	bool delta_pose_;
   	bool use_velocities_;
   	ros::Duration timeout_;
+  	bool sensor_position_; // Latest pose is position only and left at the sensor origin
 
 
   	boost::array<double, 36> pose_covariance_;
   	boost::array<double, 36> twist_covariance_;
 
+    // Read by stageTuning, applied by commitTuning
+    double staged_timeout_;
+    boost::array<double, 36> staged_pose_covariance_;
+    boost::array<double, 36> staged_twist_covariance_;
+
+    GraftSensorExtrinsics extrinsics_; // child_frame_id -> base frame
+
 };
 
 #endif
\ No newline at end of file
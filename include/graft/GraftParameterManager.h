@@ -39,6 +39,10 @@
 
 #include <graft/GraftOdometryTopic.h>
  #include <graft/GraftImuTopic.h>
+#include <graft/GraftSensorExtrinsics.h>
+#include <graft/GraftIMM.h>
+#include <graft/GraftSensorRegistry.h>
+#include <tf/transform_listener.h>
 
 class GraftParameterManager{
   public:
@@ -48,12 +52,41 @@ class GraftParameterManager{
     
     void loadParameters(std::vector<boost::shared_ptr<GraftSensor> >& topics, std::vector<ros::Subscriber>& subs);
 
-    void parseNavMsgsOdometryParameters(ros::NodeHandle& tnh, boost::shared_ptr<GraftOdometryTopic>& odom);
+    // Topics are subscribed on this queue instead when 'realtime' is set
+    void setRealtimeQueue(ros::CallbackQueueInterface* queue);
 
-    void parseSensorMsgsIMUParameters(ros::NodeHandle& tnh, boost::shared_ptr<GraftImuTopic>& imu);
+    // Sensor settings, extrinsics and innovation gate of a topic
+    void configureTopic(ros::NodeHandle& tnh, boost::shared_ptr<GraftSensor> topic);
+
+    GraftSensorExtrinsics parseExtrinsics(ros::NodeHandle& tnh);
+
+    void parseGate(ros::NodeHandle& tnh, boost::shared_ptr<GraftSensor> topic);
+
+    // gate_probability under tnh, 0 if it is not set or out of range
+    double parseGateProbability(ros::NodeHandle& tnh);
+
+    void addToUpdateGroup(ros::NodeHandle& tnh, boost::shared_ptr<GraftSensor> topic);
+
+    // Reads process_noise, keeping the current value if it is not set
+    void parseProcessNoise(std::vector<double>& process_noise);
+
+    // Reads imm_modes, modes is left empty if it is not set
+    void parseIMMModes(std::vector<GraftIMMMode>& modes);
+
+    // Re-reads the tuning parameters, the process noise of each of imm_modes
+    // if there are two or more, and the noise, covariance overrides, timeout
+    // and gate of each topic in topics.
+    // Returns false with the reason in error if a parameter cannot be parsed,
+    // process_noise does not fit a filter of state_size or imm_modes no longer
+    // names the same modes, leaving the manager and every topic unchanged.
+    bool reloadParameters(std::vector<boost::shared_ptr<GraftSensor> >& topics, const size_t state_size, std::string& error);
 
     std::string getFilterType();
 
+    std::string getProcessModel();
+
+    std::vector<boost::shared_ptr<GraftOdometryTopic> > getCascadeInputs();
+
     bool getPlanarOutput();
 
     std::string getParentFrameID();
@@ -62,6 +95,10 @@ class GraftParameterManager{
 
     double getUpdateRate();
 
+    double getOutputRate();
+
+    std::vector<GraftUpdateGroup> getUpdateGroups();
+
     std::string getUpdateTopic();
 
     double getdtOveride();
@@ -72,10 +109,50 @@ class GraftParameterManager{
 
     bool getPublishTF();
 
+    std::string getSharedMemoryName();
+
+    int getStateHistorySize();
+
+    int getSmootherLag();
+
+    bool getInitializeFromMeasurements();
+
+    double getInitializationTimeout();
+
+    double getRecoveryInflation();
+
+    int getMaxRecoveries();
+
+    double getUpdateDeadline();
+
+    bool getRealtime();
+
+    int getRealtimePriority();
+
+    int getRealtimeCPU();
+
+    bool getRealtimeLockMemory();
+
+    std::string getCheckpointFile();
+
+    double getCheckpointRate();
+
+    double getCheckpointMaxAge();
+
+    std::string getFlightRecorderFile();
+
+    size_t getFlightRecorderSize();
+
     std::vector<double> getInitialCovariance();
 
     std::vector<double> getProcessNoise();
 
+    std::vector<GraftIMMMode> getIMMModes();
+
+    double getIMMStayProbability();
+
+    bool getIMMThreads();
+
     double getAlpha();
 
     double getKappa();
@@ -88,20 +165,48 @@ class GraftParameterManager{
     ros::NodeHandle pnh_;
 
     std::string filter_type_; // EKF or UKF
+    std::string process_model_; // velocity, attitude, absolute or inertial
     bool planar_output_; // Output in 2D instead of 3D
     std::string parent_frame_id_;
     std::string child_frame_id_;
     double update_rate_; // How often to update
+    double output_rate_; // How often to publish extrapolated odometry, 0 publishes after each update
     std::string update_topic_; // Update when this topic arrives
+    std::vector<GraftUpdateGroup> update_groups_; // Topics fused together, each at its own rate
+    std::vector<boost::shared_ptr<GraftOdometryTopic> > cascade_inputs_; // Odometry topics fed in process instead of subscribed
     double dt_override_; // Overrides the dt between updates, ignored if 0
     int queue_size_;
     bool publish_tf_;
+    std::string shared_memory_name_; // Also write the state to this shared memory segment, if set
+    int state_history_size_; // Number of posteriors kept for state queries
+    int smoother_lag_; // Updates odom_smoothed lags behind, 0 disables it
+    bool initialize_from_measurements_; // Seed the state from the first measurements
+    double initialization_timeout_; // Start from initial_covariance after this many seconds, 0 waits indefinitely
+    double recovery_inflation_; // Covariance scale when rolling back a rejected estimate
+    int max_recoveries_; // Rollbacks in a row before restarting from the initial state
+    double update_deadline_; // Seconds allowed for each update before shedding load, 0 never sheds
+    bool realtime_; // Run the timed updates on a dedicated thread, see GraftRealtimeLoop
+    int realtime_priority_; // SCHED_FIFO priority of that thread, 0 keeps the default scheduler
+    int realtime_cpu_; // CPU it is pinned to, -1 for any
+    bool realtime_lock_memory_; // mlockall before it starts
+    ros::CallbackQueueInterface* realtime_queue_; // Serviced by that thread
+    std::string checkpoint_file_; // Warm start from and periodically save the state to this file, if set
+    double checkpoint_rate_; // How often to save the checkpoint
+    double checkpoint_max_age_; // Older checkpoints are ignored at startup
+    std::string flight_recorder_file_; // Record what each update saw into this file, if set
+    int flight_recorder_size_; // Megabytes of records kept
     std::vector<double> initial_covariance_;
     std::vector<double> process_noise_;
+    std::vector<GraftIMMMode> imm_modes_; // Run a GraftIMM of these if there are two or more
+    double imm_stay_probability_; // Of staying in a mode from one update to the next
+    bool imm_threads_; // Update the modes on worker threads
     double alpha_;
     double kappa_;
     double beta_;
 
+    GraftSensorRegistry registry_; // Creates topics by type, outlives them
+    boost::shared_ptr<tf::TransformListener> tf_listener_; // Shared by topics resolving extrinsics from tf
+
     // Derived parameters for filter behavior
     bool include_pose_;
 
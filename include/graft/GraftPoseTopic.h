@@ -27,74 +27,30 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-/* 
- * Author: Chad Rockey
- */
-
-#ifndef GRAFT_UKFABSOLUTE_H
-#define GRAFT_UKFABSOLUTE_H
-
-#include <Eigen/Dense>
-#include <Eigen/Cholesky>
-
-#include <graft/GraftState.h>
-#include <nav_msgs/Odometry.h>
-#include <geometry_msgs/QuaternionStamped.h>
-#include <sensor_msgs/Imu.h>
-#include <tf/transform_datatypes.h>
- #include <graft/GraftSensor.h>
-
-#define SIZE 13  // State size: x, y, z, qw, qx, qy, qz, vx, vy, vz, wx, wy, wz
+#ifndef GRAFT_POSE_TOPIC_H
+#define GRAFT_POSE_TOPIC_H
 
-using namespace Eigen;
+#include <graft/GraftOdometryTopic.h>
+#include <geometry_msgs/PoseWithCovarianceStamped.h>
 
-class GraftUKFAbsolute{
+// geometry_msgs/PoseWithCovarianceStamped, fused as the pose of an
+// Odometry message without a separate conversion node.  Uses the Odometry
+// parameters, with absolute_pose on unless delta_pose is set.  The message
+// has no child frame, so lookup_extrinsics uses 'sensor_frame_id'.
+class GraftPoseTopic: public GraftOdometryTopic {
   public:
-    GraftUKFAbsolute();
-    ~GraftUKFAbsolute();
+    GraftPoseTopic();
 
-    graft::GraftStatePtr getMessageFromState();
+    ~GraftPoseTopic();
 
-    double predictAndUpdate();
+    void poseCallback(const geometry_msgs::PoseWithCovarianceStamped::ConstPtr& msg);
 
-    void setTopics(std::vector<boost::shared_ptr<GraftSensor> >& topics);
+    virtual void configure(ros::NodeHandle& tnh);
 
-    void setInitialCovariance(std::vector<double>& P);
+    virtual ros::Subscriber subscribe(ros::NodeHandle& n, const std::string& topic, const uint32_t queue_size);
 
-    void setProcessNoise(std::vector<double>& Q);
-
-    void setAlpha(const double alpha);
-
-    void setKappa(const double kappa);
-
-    void setBeta(const double beta);
-    
   private:
-    MatrixXd f(MatrixXd x, double dt);
-
-    std::vector<MatrixXd > predict_sigma_points(std::vector<MatrixXd >& sigma_points, double dt);
-
-    graft::GraftStatePtr getMessageFromState(Matrix<double, SIZE, 1>& state, Matrix<double, SIZE, SIZE>& covariance);
-
-
-    Matrix<double, SIZE, 1> graft_state_;
-    Matrix<double, SIZE, 1> graft_control_;
-    Matrix<double, SIZE, SIZE> graft_covariance_;
-
-    Matrix<double, SIZE, SIZE> Q_;
-
-    ros::Time last_update_time_;
-    ros::Time last_imu_time_;
-
-    double alpha_;
-    double beta_;
-    double kappa_;
-
-    std::vector<boost::shared_ptr<GraftSensor> > topics_;
-
-    bool diverged_;
-
-    static const double expected_interval_;
+    std::string sensor_frame_id_;
 };
 
 #endif
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_PUBLISHING_STAGE_H
+#define GRAFT_PUBLISHING_STAGE_H
+
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+#include <boost/lockfree/queue.hpp>
+#include <graft/GraftState.h>
+#include <graft/GraftStateCompact.h>
+#include <graft/GraftGateStatistics.h>
+#include <graft/GraftLoadShedding.h>
+
+// Messages of one estimate, filled where the filter runs and published by GraftPublishingStage
+struct GraftPublishSlot{
+  graft::GraftState state;
+  graft::GraftStateCompact compact_state;
+  graft::GraftGateStatistics gate_statistics;
+  graft::GraftState smoothed_state;
+  graft::GraftLoadShedding load_shedding; // Without the frame, set when publishing
+  bool publish_state;
+  bool publish_compact_state;
+  bool publish_gate_statistics;
+  bool publish_odometry; // And tf, from state
+  bool publish_smoothed_odometry;
+  bool publish_load_shedding; // And warn if its cycle_time is set
+  double dt; // For the odometry, since the last one
+};
+
+// Publishes estimates on its own thread, so the filter never waits on
+// serialization or the network.  A fixed set of slots, whose messages keep
+// their storage from one estimate to the next, cycles between the threads
+// filling them and the publishing thread through bounded lock-free queues.
+// Any number of threads may acquire and commit.
+class GraftPublishingStage{
+  public:
+    typedef boost::function<void(const GraftPublishSlot&)> PublishFunction;
+
+    enum { SLOTS = 16 };
+
+    GraftPublishingStage();
+
+    ~GraftPublishingStage();
+
+    void start(PublishFunction publish);
+
+    // Publishes what was committed before returning
+    void stop();
+
+    // A free slot to fill, NULL if publishing is falling behind
+    GraftPublishSlot* acquire();
+
+    // Hands an acquired slot to the publishing thread
+    void commit(GraftPublishSlot* slot);
+
+  private:
+    void loop();
+
+    // Publishes every committed slot and frees it
+    void drain();
+
+    PublishFunction publish_;
+    std::vector<GraftPublishSlot> slots_;
+    boost::lockfree::queue<GraftPublishSlot*, boost::lockfree::capacity<SLOTS> > free_;
+    boost::lockfree::queue<GraftPublishSlot*, boost::lockfree::capacity<SLOTS> > committed_;
+
+    // Wakes the publishing thread.  wake_mutex_ is only held to count the
+    // commits, so a committing thread waits at most for that.
+    boost::mutex wake_mutex_;
+    boost::condition_variable wake_;
+    size_t pending_; // Commits not yet drained
+    boost::thread thread_;
+};
+
+#endif
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_QUATERNION_H
+#define GRAFT_QUATERNION_H
+
+#include <cmath>
+#include <Eigen/Dense>
+#include <ros/console.h>
+#include <tf/transform_datatypes.h>
+#include <graft/GraftScalar.h>
+
+// Quaternion helpers shared by the process models, quaternions are stored w, x, y, z
+
+inline Eigen::Matrix<GraftScalar, 4, 1> unitQuaternion(const Eigen::Matrix<GraftScalar, 4, 1>& q){
+  double q_mag = std::sqrt(q(0)*q(0) + q(1)*q(1) + q(2)*q(2) + q(3)*q(3));
+  if( q_mag < 0.1 ) {
+    ROS_WARN("SMALL QUATERNION. HARD TO NORMALIZE");
+  }
+  return q / q_mag;
+}
+
+inline Eigen::Matrix<GraftScalar, 4, 4> quaternionUpdateMatrix(const double wx, const double wy, const double wz){
+  Eigen::Matrix<GraftScalar, 4, 4> out;
+  out <<   0,  wx,  wy,  wz,
+         -wx,   0, -wz,  wy,
+         -wy,  wz,   0, -wx,
+         -wz, -wy,  wx,   0;
+  return out;
+}
+
+inline Eigen::Matrix<GraftScalar, 4, 1> updatedQuaternion(const Eigen::Matrix<GraftScalar, 4, 1>& q, const double wx, const double wy, const double wz, const double dt){
+  double s = 1.0/2.0 * std::sqrt(wx*wx*dt*dt + wy*wy*dt*dt + wz*wz*dt*dt);
+  double correction_factor = 1 - 1.0/2.0*s*s + 1.0/24.0*s*s*s*s; // Cosine taylor series
+  double update_factor = 1.0/2.0*dt*(1.0 - 1.0/6.0*s*s + 1.0/120.0*s*s*s*s); // Sinc taylor series
+  Eigen::Matrix<GraftScalar, 4, 4> step = GraftScalar(correction_factor)*Eigen::Matrix<GraftScalar, 4, 4>::Identity()
+                                        - GraftScalar(update_factor)*quaternionUpdateMatrix(wx, wy, wz);
+  return step*q;
+}
+
+// Rotates a body frame vector into the parent frame
+inline Eigen::Matrix<GraftScalar, 3, 1> transformVelocities(const Eigen::Matrix<GraftScalar, 3, 1>& vel, const Eigen::Matrix<GraftScalar, 4, 1>& quaternion){
+  Eigen::Matrix<GraftScalar, 4, 1> unit_q = unitQuaternion(quaternion);
+  tf::Quaternion tfq(unit_q(1), unit_q(2), unit_q(3), unit_q(0));
+  tf::Transform tft(tfq, tf::Vector3(0, 0, 0));
+  tf::Vector3 transformed = tft*tf::Vector3(vel(0), vel(1), vel(2));
+  Eigen::Matrix<GraftScalar, 3, 1> out;
+  out(0) = transformed.getX();
+  out(1) = transformed.getY();
+  out(2) = transformed.getZ();
+  return out;
+}
+
+// Diagonal of the quaternion covariance for a roll, pitch, yaw covariance, q1..q4 are x, y, z, w
+inline Eigen::Matrix<GraftScalar, 4, 1> quaternionCovFromEuler(const double roll_cov, const double pitch_cov,
+    const double yaw_cov,
+    const double q1, const double q2, const double q3, const double q4) {
+  // Euler covariance matrix
+  Eigen::Matrix<GraftScalar, 3, 3> euler_cov;
+  euler_cov.setZero();
+  euler_cov(0) = roll_cov;
+  euler_cov(4) = pitch_cov;
+  euler_cov(8) = yaw_cov;
+
+  double yaw = atan((q3+q2)/(q4+q1)) + atan((q3-q1)/(q4-q1));
+  double pitch = asin(2*(q2*q3 + q1*q4));
+  double roll = atan((q3+q2)/(q4+q1)) - atan((q3-q2)/(q4-q1));
+
+  double sss = sin(yaw/2)*sin(roll/2)*sin(pitch/2)/2;
+  double ssc = sin(yaw/2)*sin(roll/2)*cos(pitch/2)/2;
+  double scs = sin(yaw/2)*cos(roll/2)*sin(pitch/2)/2;
+  double scc = sin(yaw/2)*cos(roll/2)*cos(pitch/2)/2;
+
+  double ccc = cos(yaw/2)*cos(roll/2)*cos(pitch/2)/2;
+  double ccs = cos(yaw/2)*cos(roll/2)*sin(pitch/2)/2;
+  double csc = cos(yaw/2)*sin(roll/2)*cos(pitch/2)/2;
+  double css = cos(yaw/2)*sin(roll/2)*sin(pitch/2)/2;
+
+  // Euler to Quaternion Jacobian
+  Eigen::Matrix<GraftScalar, 4, 3> G;
+
+  G(0, 0) = -scs - csc; // q1/yaw
+  G(0, 1) =  ccc + sss; // q1/pitch
+  G(0, 2) = -css - scc; // q1/roll
+
+  G(1, 0) =  ccs - ssc; // q2/yaw
+  G(1, 1) =  ssc - css; // q2/pitch
+  G(1, 2) = -sss + ccc; // q2/roll
+
+  G(2, 0) =  ccc - sss; // q3/yaw
+  G(2, 1) = -scs + csc; // q3/pitch
+  G(2, 2) = -ssc + ccs; // q3/roll
+
+  G(3, 0) = -scc - css; // q4/yaw
+  G(3, 1) = -ccs - ssc; // q4/pitch
+  G(3, 2) = -csc - scs; // q4/roll
+
+  // Quaternion covariance
+  Eigen::Matrix<GraftScalar, 4, 4> quat_cov = G * euler_cov * G.transpose();
+  return quat_cov.diagonal();
+}
+
+#endif
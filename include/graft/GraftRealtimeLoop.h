@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_REALTIME_LOOP_H
+#define GRAFT_REALTIME_LOOP_H
+
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+#include <boost/function.hpp>
+#include <boost/thread.hpp>
+#include <graft/GraftSensor.h>
+#include <graft/GraftRealtimeStatistics.h>
+
+// Runs the timed update groups on a dedicated thread that wakes on absolute
+// CLOCK_MONOTONIC deadlines with clock_nanosleep, optionally at SCHED_FIFO
+// priority, pinned to one CPU and with the process memory locked.  Each cycle
+// also services the callback queue the topics are subscribed on, so their
+// messages and arrival triggered groups are handled on the same thread.  The
+// mutex is held for the whole cycle.
+class GraftRealtimeLoop{
+  public:
+    typedef boost::function<void(GraftUpdateGroup&)> UpdateFunction;
+    typedef boost::function<void(const graft::GraftRealtimeStatistics&)> StatisticsFunction;
+
+    GraftRealtimeLoop(ros::CallbackQueue* queue, boost::mutex& mutex, UpdateFunction update, StatisticsFunction statistics);
+
+    ~GraftRealtimeLoop();
+
+    // SCHED_FIFO priority of the thread, 0 keeps the default scheduler
+    void setPriority(const int priority);
+
+    // Pin the thread to this CPU, -1 lets it run anywhere
+    void setCPU(const int cpu);
+
+    // mlockall the process before starting, so the loop never page faults
+    void setLockMemory(const bool lock_memory);
+
+    // Groups with a rate run at it, the queue is also serviced at idle_rate if none has one
+    void start(const std::vector<GraftUpdateGroup>& groups, const double idle_rate);
+
+    void stop();
+
+  private:
+    void loop();
+
+    // Scheduler and affinity of the calling thread
+    void configureThread();
+
+    void report(const int64_t now);
+
+    ros::CallbackQueue* queue_;
+    boost::mutex& mutex_;
+    UpdateFunction update_;
+    StatisticsFunction statistics_;
+
+    int priority_;
+    int cpu_;
+    bool lock_memory_;
+
+    std::vector<GraftUpdateGroup> groups_;
+    std::vector<int64_t> periods_; // Nanoseconds, of each group
+    std::vector<int64_t> deadlines_; // Next wake up of each group, CLOCK_MONOTONIC nanoseconds
+    boost::thread thread_;
+
+    // Jitter since the last report
+    int64_t last_report_;
+    uint32_t cycles_;
+    uint32_t overruns_;
+    double jitter_sum_;
+    double jitter_squared_sum_;
+    double jitter_max_;
+    double cycle_time_max_;
+};
+
+#endif
@@ -35,7 +35,10 @@
 #define GRAFT_SENSOR_H_
 
 #include <ros/ros.h>
+#include <boost/function.hpp>
 #include <Eigen/Dense>
+#include <graft/GraftInnovationGate.h>
+#include <graft/GraftSensorExtrinsics.h>
 #include <graft/GraftState.h>
 #include <graft/GraftSensorResidual.h>
 
@@ -43,15 +46,41 @@
 
 using namespace Eigen;
 
+// A measurement source.  Sensors are created by type through
+// GraftSensorRegistry, so they need a default constructor.
 class GraftSensor{
   public:
     virtual ~GraftSensor(){}
 
+    // Reads this topic's settings under tnh, at startup and on ~reload_parameters
+    virtual void configure(ros::NodeHandle& tnh) = 0;
+
+    // Reads the noise settings, covariance overrides and timeout under tnh
+    // without applying them, may throw XmlRpc::XmlRpcException.  Overrides no
+    // longer set go back to the message.
+    virtual void stageTuning(ros::NodeHandle& tnh){}
+
+    // Applies what stageTuning read.  ~reload_parameters stages every topic
+    // before committing any, so a failed reload leaves all of them unchanged.
+    virtual void commitTuning(){}
+
+    void configureTuning(ros::NodeHandle& tnh){
+      stageTuning(tnh);
+      commitTuning();
+    }
+
+    virtual ros::Subscriber subscribe(ros::NodeHandle& n, const std::string& topic, const uint32_t queue_size) = 0;
+
+    // Sensor frame -> base frame, ignored by sensors that do not need it
+    virtual void setExtrinsics(const GraftSensorExtrinsics& extrinsics){}
+
     //virtual MatrixXd H(graft::GraftState& state) = 0;
 
     virtual graft::GraftSensorResidual::Ptr z() = 0;
 
-    virtual graft::GraftSensorResidual::Ptr h(const graft::GraftState& state) = 0;
+    // Measurement predicted from state, written into out.  The filter reuses
+    // out between updates, so filling it in place does not allocate.
+    virtual void h(const graft::GraftState& state, graft::GraftSensorResidual& out) = 0;
 
     virtual void setName(const std::string& name) = 0;
 
@@ -61,13 +90,47 @@ class GraftSensor{
 
     //virtual graft::GraftSensorResidual y(graft::GraftState& predicted) = 0;
 
+    // Previous message of sensors that fuse deltas, saved in checkpoints.
+    // Returns false if the sensor has none.
+    virtual bool getDeltaMemory(ros::Time& stamp, geometry_msgs::Pose& pose){
+      return false;
+    }
+
+    virtual void setDeltaMemory(const ros::Time& stamp, const geometry_msgs::Pose& pose){}
+
     //virtual MatrixXd R() = 0;
 
+    // Consistency test of this topic's measurements, applied by the filter
+    GraftInnovationGate& getGate(){
+      return gate_;
+    }
+
+    // Called after each new message, used to fuse update groups on arrival
+    void setArrivalCallback(const boost::function<void()>& callback){
+      arrival_callback_ = callback;
+    }
+
+  protected:
+
+    void notifyArrival(){
+      if(arrival_callback_){
+        arrival_callback_();
+      }
+    }
+
   private:
 
-    
+    boost::function<void()> arrival_callback_;
+
+    GraftInnovationGate gate_;
+};
 
-    
+// A set of topics fused together at their own rate
+struct GraftUpdateGroup{
+  std::string name;
+  double rate; // Hz, 0 fuses on every message arrival
+  int priority; // Highest of its topics, only the highest groups run when shedding load
+  std::vector<boost::shared_ptr<GraftSensor> > topics;
 };
 
 #endif
\ No newline at end of file
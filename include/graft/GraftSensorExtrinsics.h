@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_SENSOR_EXTRINSICS_H
+#define GRAFT_SENSOR_EXTRINSICS_H
+
+#include <ros/ros.h>
+#include <Eigen/Dense>
+#include <boost/array.hpp>
+#include <geometry_msgs/Pose.h>
+#include <geometry_msgs/Twist.h>
+#include <geometry_msgs/Vector3.h>
+#include <tf/transform_listener.h>
+
+using namespace Eigen;
+
+// Pose of a sensor frame in the base frame, resolved once and applied to each measurement
+class GraftSensorExtrinsics{
+  public:
+    GraftSensorExtrinsics();
+
+    ~GraftSensorExtrinsics();
+
+    // Fixed transform from parameters: x, y, z, roll, pitch, yaw
+    void setTransform(const std::vector<double>& xyzrpy);
+
+    // Look up the transform from tf the first time each sensor frame is seen
+    void setTransformListener(const boost::shared_ptr<tf::TransformListener>& listener, const std::string& base_frame_id);
+
+    // Returns false while the transform for this sensor frame is unknown
+    bool resolve(const std::string& sensor_frame_id);
+
+    bool isIdentity();
+
+    // Pose of the sensor frame -> pose of the base frame, with its covariance.
+    // Position only poses are left at the sensor origin, the filter predicts
+    // them with sensorPosition from its own orientation estimate.
+    void transformPose(geometry_msgs::Pose& pose, boost::array<double, 36>& covariance);
+
+    // Base frame pose -> position of the sensor origin
+    void sensorPosition(geometry_msgs::Pose& pose);
+
+    // True if the orientation of pose is unmeasured, as from GPS
+    static bool isPositionOnly(const geometry_msgs::Pose& pose, const boost::array<double, 36>& covariance);
+
+    // Sensor frame twist -> base frame twist, including the lever arm
+    void transformTwist(geometry_msgs::Twist& twist, boost::array<double, 36>& covariance);
+
+    // Sensor frame orientation -> base frame orientation
+    void transformOrientation(geometry_msgs::Quaternion& orientation);
+
+    // Sensor frame angular velocity -> base frame angular velocity
+    void transformAngularVelocity(geometry_msgs::Vector3& angular_velocity, boost::array<double, 36>& covariance);
+
+    // Sensor frame acceleration -> base frame acceleration, removing the centripetal term of the lever arm
+    void transformAcceleration(geometry_msgs::Vector3& accel, const geometry_msgs::Vector3& base_angular_velocity, boost::array<double, 9>& covariance);
+
+  private:
+
+    void set(const Matrix3d& rotation, const Vector3d& translation);
+
+    boost::shared_ptr<tf::TransformListener> listener_;
+    std::string base_frame_id_;
+    std::string sensor_frame_id_; // Frame the cached transform was resolved for
+    bool fixed_; // Set from parameters, never looked up
+    bool resolved_;
+    bool identity_;
+
+    Matrix3d rotation_; // Sensor axes in the base frame
+    Vector3d translation_; // Sensor origin in the base frame
+    Matrix3d lever_arm_; // Maps sensor angular velocity to base linear velocity
+};
+
+#endif
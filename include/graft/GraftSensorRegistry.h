@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_SENSOR_REGISTRY_H
+#define GRAFT_SENSOR_REGISTRY_H
+
+#include <map>
+#include <string>
+#include <boost/shared_ptr.hpp>
+#include <pluginlib/class_loader.hpp>
+#include <graft/GraftSensor.h>
+
+// Creates topics from the 'type' in their configuration.  The message types
+// below are built in, any other type is loaded through pluginlib from
+// packages exporting a GraftSensor plugin with that type as its name:
+//
+//   <export><graft plugin="${prefix}/graft_plugins.xml"/></export>
+//
+//   <class name="my_msgs/Range" type="my_pkg::RangeTopic" base_class_type="GraftSensor"/>
+//
+// Plugin instances must be destroyed before the registry.
+class GraftSensorRegistry{
+  public:
+    typedef boost::shared_ptr<GraftSensor> (*Factory)();
+
+    // Registers nav_msgs/Odometry, sensor_msgs/Imu, sensor_msgs/NavSatFix, sensor_msgs/JointState,
+    // geometry_msgs/PoseWithCovarianceStamped and geometry_msgs/TwistWithCovarianceStamped
+    GraftSensorRegistry();
+
+    ~GraftSensorRegistry();
+
+    void add(const std::string& type, Factory factory);
+
+    // NULL if type is neither built in nor an exported plugin
+    boost::shared_ptr<GraftSensor> create(const std::string& type);
+
+  private:
+    std::map<std::string, Factory> factories_;
+    boost::shared_ptr<pluginlib::ClassLoader<GraftSensor> > loader_; // Created on first use
+};
+
+#endif
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_SHARED_STATE_H
+#define GRAFT_SHARED_STATE_H
+
+// Header-only reader for the shared memory state written by the graft nodes
+// when 'shared_memory_name' is set.  It has no ROS dependencies, link with
+// -lrt on older glibc for shm_open.
+//
+// The writer bumps 'sequence' to an odd value, copies the estimate and bumps
+// it again to an even value.  Readers copy the estimate and retry if the
+// sequence was odd or changed, so reading never blocks the writer and makes
+// no system calls once the segment is mapped.
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define GRAFT_SHARED_STATE_MAGIC 0x47524654 // "GRFT"
+#define GRAFT_SHARED_STATE_VERSION 1
+
+struct GraftSharedEstimate{
+  uint32_t stamp_sec;
+  uint32_t stamp_nsec;
+  uint32_t size; // Filter state size, covariance holds size*size elements
+  uint32_t reserved;
+
+  double position[3]; // x, y, z
+  double orientation[4]; // x, y, z, w
+  double linear_velocity[3]; // vx, vy, vz
+  double angular_velocity[3]; // wx, wy, wz
+
+  double covariance[324]; // Same layout as graft/GraftState covariance
+};
+
+struct GraftSharedState{
+  uint32_t magic;
+  uint32_t version;
+  uint32_t sequence; // Odd while an estimate is being written
+  uint32_t reserved;
+
+  GraftSharedEstimate estimate;
+};
+
+class GraftSharedStateReader{
+  public:
+    GraftSharedStateReader(): data_(NULL){}
+
+    ~GraftSharedStateReader(){
+      close();
+    }
+
+    bool open(const std::string& name){
+      close();
+      int fd = shm_open(name.c_str(), O_RDONLY, 0);
+      if(fd < 0){
+        return false;
+      }
+      void* mem = mmap(NULL, sizeof(GraftSharedState), PROT_READ, MAP_SHARED, fd, 0);
+      ::close(fd);
+      if(mem == MAP_FAILED){
+        return false;
+      }
+      data_ = static_cast<const GraftSharedState*>(mem);
+      if(data_->magic != GRAFT_SHARED_STATE_MAGIC || data_->version != GRAFT_SHARED_STATE_VERSION){
+        close();
+        return false;
+      }
+      return true;
+    }
+
+    void close(){
+      if(data_ != NULL){
+        munmap(const_cast<GraftSharedState*>(data_), sizeof(GraftSharedState));
+        data_ = NULL;
+      }
+    }
+
+    bool isOpen() const{
+      return data_ != NULL;
+    }
+
+    // Single attempt, returns false if the writer was mid-update or nothing
+    // has been written yet.
+    bool tryRead(GraftSharedEstimate& out) const{
+      if(data_ == NULL){
+        return false;
+      }
+      uint32_t before = __atomic_load_n(&data_->sequence, __ATOMIC_ACQUIRE);
+      if(before == 0 || (before & 1)){
+        return false;
+      }
+      memcpy(&out, &data_->estimate, sizeof(GraftSharedEstimate));
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);
+      uint32_t after = __atomic_load_n(&data_->sequence, __ATOMIC_RELAXED);
+      return before == after;
+    }
+
+    // Retries a bounded number of times, the writer only holds the sequence
+    // odd for the duration of one copy.
+    bool read(GraftSharedEstimate& out, int max_attempts = 16) const{
+      for(int i = 0; i < max_attempts; i++){
+        if(tryRead(out)){
+          return true;
+        }
+      }
+      return false;
+    }
+
+  private:
+    const GraftSharedState* data_;
+};
+
+#endif
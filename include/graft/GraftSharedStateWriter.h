@@ -27,70 +27,31 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-/* 
- * Author: Chad Rockey
- */
-
-#ifndef GRAFT_UKFVELOCITY_H
-#define GRAFT_UKFVELOCITY_H
-
-#include <Eigen/Dense>
-#include <Eigen/Cholesky>
+#ifndef GRAFT_SHARED_STATE_WRITER_H
+#define GRAFT_SHARED_STATE_WRITER_H
 
+#include <ros/ros.h>
 #include <graft/GraftState.h>
-#include <nav_msgs/Odometry.h>
-#include <geometry_msgs/QuaternionStamped.h>
-#include <sensor_msgs/Imu.h>
-#include <tf/transform_datatypes.h>
- #include <graft/GraftSensor.h>
-
-#define SIZE 3  // State size: vx, vy, wz
+#include <graft/GraftSharedState.h>
 
-using namespace Eigen;
-
-class GraftUKFVelocity{
+class GraftSharedStateWriter{
   public:
-    GraftUKFVelocity();
-    ~GraftUKFVelocity();
-
-	MatrixXd f(MatrixXd x, double dt);
-
-	std::vector<MatrixXd > predict_sigma_points(std::vector<MatrixXd >& sigma_points, double dt);
+    GraftSharedStateWriter();
 
-	graft::GraftStatePtr getMessageFromState();
+    ~GraftSharedStateWriter();
 
-	graft::GraftStatePtr getMessageFromState(Matrix<double, SIZE, 1>& state, Matrix<double, SIZE, SIZE>& covariance);
+    bool open(const std::string& name);
 
-	double predictAndUpdate();
+    void close();
 
-	void setTopics(std::vector<boost::shared_ptr<GraftSensor> >& topics);
+    bool isOpen();
 
-	void setInitialCovariance(std::vector<double>& P);
+    void write(const graft::GraftState& state, const size_t size);
 
-	void setProcessNoise(std::vector<double>& Q);
-
-	void setAlpha(const double alpha);
-
-	void setKappa(const double kappa);
-
-	void setBeta(const double beta);
-    
   private:
 
-    Matrix<double, SIZE, 1> graft_state_;
-	Matrix<double, SIZE, 1> graft_control_;
-	Matrix<double, SIZE, SIZE> graft_covariance_;
-
-	Matrix<double, SIZE, SIZE> Q_;
-
-    ros::Time last_update_time_;
-    ros::Time last_imu_time_;
-
-    double alpha_;
-    double beta_;
-    double kappa_;
-
-    std::vector<boost::shared_ptr<GraftSensor> > topics_;
+    std::string name_;
+    GraftSharedState* data_;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_STATE_HISTORY_H
+#define GRAFT_STATE_HISTORY_H
+
+#include <ros/ros.h>
+#include <Eigen/Dense>
+#include <Eigen/StdVector>
+
+using namespace Eigen;
+
+// Fixed capacity ring of posterior states, oldest entries are overwritten.
+template<int N, typename Scalar = double>
+class GraftStateHistory{
+  public:
+    typedef Matrix<Scalar, N, 1> StateVector;
+    typedef Matrix<Scalar, N, N> CovarianceMatrix;
+
+    GraftStateHistory(){
+      setCapacity(100);
+    }
+
+    void setCapacity(size_t capacity){
+      if(capacity < 1){
+        capacity = 1;
+      }
+      stamps_.assign(capacity, ros::Time());
+      states_.assign(capacity, StateVector::Zero());
+      covariances_.assign(capacity, CovarianceMatrix::Zero());
+      clear();
+    }
+
+    void clear(){
+      next_ = 0;
+      count_ = 0;
+    }
+
+    size_t size() const{
+      return count_;
+    }
+
+    void add(const ros::Time& stamp, const StateVector& state, const CovarianceMatrix& covariance){
+      if(count_ > 0 && stamp < stamps_[index(count_-1)]){ // Time went backwards, start over
+        clear();
+      }
+      stamps_[next_] = stamp;
+      states_[next_] = state;
+      covariances_[next_] = covariance;
+      next_ = (next_ + 1) % stamps_.size();
+      if(count_ < stamps_.size()){
+        count_++;
+      }
+    }
+
+    bool newest(ros::Time& stamp, StateVector& state, CovarianceMatrix& covariance) const{
+      if(count_ == 0){
+        return false;
+      }
+      size_t i = index(count_-1);
+      stamp = stamps_[i];
+      state = states_[i];
+      covariance = covariances_[i];
+      return true;
+    }
+
+    // Linear interpolation between the two posteriors around stamp.  Returns
+    // false if stamp is outside of the stored history.
+    bool interpolate(const ros::Time& stamp, StateVector& state, CovarianceMatrix& covariance) const{
+      if(count_ == 0 || stamp < stamps_[index(0)] || stamp > stamps_[index(count_-1)]){
+        return false;
+      }
+      for(size_t i = count_-1; i > 0; i--){ // Most queries are recent, search from the newest
+        size_t a = index(i-1);
+        size_t b = index(i);
+        if(stamp < stamps_[a]){
+          continue;
+        }
+        double span = (stamps_[b] - stamps_[a]).toSec();
+        Scalar t = span > 1e-9 ? (stamp - stamps_[a]).toSec() / span : 1.0;
+        state = (1 - t) * states_[a] + t * states_[b];
+        covariance = (1 - t) * covariances_[a] + t * covariances_[b];
+        return true;
+      }
+      state = states_[index(0)]; // Exactly the oldest stamp
+      covariance = covariances_[index(0)];
+      return true;
+    }
+
+  private:
+
+    // i = 0 is the oldest stored entry
+    size_t index(size_t i) const{
+      return (next_ + stamps_.size() - count_ + i) % stamps_.size();
+    }
+
+    std::vector<ros::Time> stamps_;
+    std::vector<StateVector, aligned_allocator<StateVector> > states_;
+    std::vector<CovarianceMatrix, aligned_allocator<CovarianceMatrix> > covariances_;
+    size_t next_;
+    size_t count_;
+};
+
+#endif
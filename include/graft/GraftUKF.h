@@ -0,0 +1,282 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_UKF_H
+#define GRAFT_UKF_H
+
+#include <Eigen/Dense>
+#include <Eigen/Cholesky>
+#include <boost/thread/mutex.hpp>
+
+#include <graft/GraftFilter.h>
+#include <graft/GraftScalar.h>
+#include <graft/GraftCovarianceUpdate.h>
+#include <graft/GraftFixedLagSmoother.h>
+#include <graft/GraftMeasurementSet.h>
+#include <graft/GraftStateHistory.h>
+
+// Unscented Kalman filter over ProcessModel, see GraftVelocityModel for the
+// members a model provides.  Instantiated for each model in GraftUKF.cpp.
+template<class ProcessModel>
+class GraftUKF : public GraftFilter{
+  public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    enum { SIZE = ProcessModel::SIZE };
+
+    typedef Eigen::Matrix<GraftScalar, SIZE, 1> StateVector;
+    typedef Eigen::Matrix<GraftScalar, SIZE, SIZE> CovarianceMatrix;
+
+    typedef std::vector<graft::GraftSensorResidual::ConstPtr> Measurements;
+
+    GraftUKF();
+    ~GraftUKF();
+
+    graft::GraftStatePtr getMessageFromState();
+
+    graft::GraftStateCompactPtr getCompactMessageFromState();
+
+    graft::GraftStatePtr getMessageAtTime(const ros::Time& stamp);
+
+    void getMessageFromState(graft::GraftState& msg);
+
+    void getCompactMessageFromState(graft::GraftStateCompact& msg);
+
+    bool getMessageAtTime(const ros::Time& stamp, graft::GraftState& msg);
+
+    ros::Time getStateTime();
+
+    double predictAndUpdate();
+
+    double predictAndUpdate(std::vector<boost::shared_ptr<GraftSensor> >& topics);
+
+    void setTopics(std::vector<boost::shared_ptr<GraftSensor> >& topics);
+
+    void setInitialCovariance(std::vector<double>& P);
+
+    void setProcessNoise(std::vector<double>& Q);
+
+    // No modes, ignored
+    void setModeProcessNoise(std::vector<std::vector<double> >& Q);
+
+    void setAlpha(const double alpha);
+
+    void setKappa(const double kappa);
+
+    void setBeta(const double beta);
+
+    void setStateHistorySize(const size_t size);
+
+    void setInitializeFromMeasurements(const bool initialize, const double timeout);
+
+    bool isReady();
+
+    void setRecovery(const double inflation, const int max_recoveries);
+
+    void setRecoveryCallback(RecoveryFunction callback);
+
+    void setMeanOnlyPrediction(const bool mean_only);
+
+    void setFlightRecorder(GraftFlightRecorder* recorder);
+
+    void setSmootherLag(const size_t lag);
+
+    bool getSmoothedMessage(graft::GraftState& msg);
+
+    bool getPosterior(std::vector<double>& state, std::vector<double>& covariance);
+
+    bool restorePosterior(const ros::Time& stamp, const std::vector<double>& state, const std::vector<double>& covariance);
+
+    size_t size();
+
+    void updateOdometry(const graft::GraftState& state, const double dt, nav_msgs::Odometry& odom);
+
+    // The measurement of each topic, z[i] of topics[i].  GraftSensor::z may
+    // advance the topic, so it is read once per update.
+    static void readMeasurements(const std::vector<boost::shared_ptr<GraftSensor> >& topics, Measurements& z);
+
+    // predictAndUpdate at t from measurements read by readMeasurements.
+    // consumed is set if the messages of the topics were used and can be cleared.
+    double update(const ros::Time& t, std::vector<boost::shared_ptr<GraftSensor> >& topics, const Measurements& z, bool& consumed);
+
+    const StateVector& getState() const{
+      return graft_state_;
+    }
+
+    const CovarianceMatrix& getCovariance() const{
+      return graft_covariance_;
+    }
+
+    // Replaces the estimate with one as of t, as after an update
+    void setPosterior(const ros::Time& t, const StateVector& state, const CovarianceMatrix& covariance);
+
+    // Runs as a mode of GraftIMM: computes the likelihood of each update and
+    // tests the gates of the topics, shared with the other modes, under gate_mutex
+    void setIMMMode(boost::mutex* gate_mutex);
+
+    // Whether the gate tests of this mode's updates are recorded in the gate
+    // statistics, of only one mode per update in GraftIMM
+    void setRecordGates(const bool record);
+
+    // Of the measurements of the last update before gating, false if it had
+    // none or was recovered
+    bool getLogLikelihood(double& log_likelihood);
+
+  private:
+    typedef Eigen::Matrix<GraftScalar, SIZE, 2*SIZE+1> SigmaPoints;
+
+    typedef StateVector (*StepFunction)(const StateVector& x, const double dt);
+
+    // step over dt in steps of at most ProcessModel::maxTimeStep, ProcessModel::f
+    // for predictions and ProcessModel::extrapolate for queries past the newest update
+    static StateVector propagate(const StateVector& x, const double dt, StepFunction step = &ProcessModel::f);
+
+    // False if the covariance can not be decomposed
+    bool generateSigmaPoints(const StateVector& mean, const CovarianceMatrix& covariance, SigmaPoints& sigma_points);
+
+    // NULL if the estimate can be used, otherwise why not
+    const char* checkHealth(const StateVector& state, const CovarianceMatrix& covariance);
+
+    // Index into topics of the largest normalized innovation of the last update
+    size_t offendingTopic(const GraftVector& innovation, const GraftMatrix& innovation_covariance, double& nis);
+
+    // Replaces a rejected estimate, see GraftFilter::setRecovery
+    void recover(const ros::Time& t, const char* reason, const std::string& topic, const double nis);
+
+    void updateWeights();
+
+    // Seeds the state from the topics until the model has what it requires
+    void initializeFromMeasurements(const ros::Time& t, const Measurements& z);
+
+    // Fills measurements_ from each topic and the rows of each, returns false if there are none
+    bool getMeasurements(const std::vector<boost::shared_ptr<GraftSensor> >& topics, const Measurements& z, const SigmaPoints& sigma_points);
+
+    // Measurement vector, its prediction from sigma_points_, their deviations and the innovation covariance
+    void predictMeasurements(GraftVector& z, GraftVector& predicted, GraftMatrix& deviations, GraftMatrix& covariance);
+
+    // Sizes the update buffers for rows measurements, nothing to do if the last update had as many
+    void resizeUpdate(const size_t rows);
+
+    // Of the measurements_ just predicted, into the members below
+    void computeGain(const StateVector& predicted_mean);
+
+    // GraftInnovationGate::test, or ::accepts unless recording, threshold is that of rows
+    bool testGate(GraftInnovationGate& gate, const double nis, const size_t rows, double& threshold);
+
+    // Removes the measurements of each topic its gate rejects, returns true if any were
+    bool gateMeasurements(std::vector<boost::shared_ptr<GraftSensor> >& topics, const GraftVector& innovation, const GraftMatrix& innovation_covariance);
+
+    void getMessageFromState(const StateVector& state, const CovarianceMatrix& covariance, graft::GraftState& msg);
+
+    // Index of a topic in the flight record, GRAFT_FLIGHT_RECORDER_TOPICS if it is not recorded
+    uint32_t flightTopic(const GraftSensor& topic);
+
+    // Ends the flight record of an update with the estimate it left
+    void recordCycle(const GraftFlightOutcome outcome);
+
+    // Gaussian log-likelihood of the innovation
+    void updateLogLikelihood(const GraftVector& innovation, const GraftMatrix& innovation_covariance);
+
+    StateVector graft_state_;
+    CovarianceMatrix graft_covariance_;
+
+    CovarianceMatrix Q_;
+
+    // Preallocated for each update
+    SigmaPoints sigma_points_;
+    SigmaPoints predicted_sigma_points_;
+    Eigen::Matrix<GraftScalar, 2*SIZE+1, 1> mean_weights_;
+    Eigen::Matrix<GraftScalar, 2*SIZE+1, 1> covariance_weights_;
+    std::vector<graft::GraftState> sigma_msgs_;
+    GraftMeasurementSet::Residuals residuals_; // h() of each sigma point for one topic
+    GraftMeasurementSet measurements_;
+    std::vector<size_t> measurement_topics_; // Index into topics of each topic in measurements_
+    std::vector<size_t> measurement_ends_; // One past its last row in measurements_
+
+    // Sized by resizeUpdate to the measurements of the last update, an
+    // update with as many rows reuses them without allocating
+    typedef Eigen::Matrix<GraftScalar, SIZE, Eigen::Dynamic> GainMatrix;
+    size_t update_rows_;
+    GraftVector measurement_;
+    GraftVector measurement_noise_;
+    GraftMatrix measurement_sigma_points_;
+    GraftVector predicted_measurement_;
+    GraftMatrix measurement_deviations_;
+    GraftMatrix weighted_measurement_deviations_;
+    GraftMatrix innovation_covariance_;
+    GraftMatrix innovation_covariance_inverse_;
+    Eigen::PartialPivLU<GraftMatrix> innovation_lu_;
+    Eigen::LDLT<GraftMatrix> innovation_ldlt_; // For the log-likelihood
+    GraftVector innovation_;
+    GraftVector weighted_innovation_;
+    SigmaPoints weighted_state_deviations_;
+    GainMatrix cross_covariance_;
+    GainMatrix gain_;
+    GainMatrix gain_workspace_;
+
+    ros::Time last_update_time_;
+
+    double alpha_;
+    double beta_;
+    double kappa_;
+    double lambda_;
+
+    StateVector initial_state_;
+    CovarianceMatrix initial_covariance_;
+
+    double recovery_inflation_;
+    int max_recoveries_;
+    int recoveries_; // Since the last healthy update
+    RecoveryFunction recovery_callback_;
+
+    bool ready_; // State initialized, updates run
+    bool initialize_from_measurements_;
+    unsigned int initialized_; // GraftInitialization parts seeded so far
+    ros::Time initialization_start_;
+    double initialization_timeout_;
+
+    bool mean_only_prediction_; // Skip propagating the sigma points, see GraftFilter::setMeanOnlyPrediction
+
+    GraftFlightRecorder* flight_recorder_; // NULL if not recording
+    GraftFlightCycle flight_cycle_; // Of the current update
+
+    std::vector<boost::shared_ptr<GraftSensor> > topics_;
+    Measurements z_; // Of the topics in predictAndUpdate
+
+    double log_likelihood_;
+    bool log_likelihood_valid_;
+    boost::mutex* gate_mutex_; // NULL unless a mode of GraftIMM
+    bool record_gates_;
+
+    GraftStateHistory<SIZE, GraftScalar> history_; // Recent posteriors for getMessageAtTime
+
+    GraftFixedLagSmoother<SIZE, GraftScalar> smoother_;
+};
+
+#endif
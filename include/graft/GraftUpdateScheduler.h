@@ -27,70 +27,36 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
-/* 
- * Author: Chad Rockey
- */
-
-#ifndef GRAFT_UKFATTITUDE_H
-#define GRAFT_UKFATTITUDE_H
-
-#include <Eigen/Dense>
-#include <Eigen/Cholesky>
-
-#include <graft/GraftState.h>
-#include <nav_msgs/Odometry.h>
-#include <geometry_msgs/QuaternionStamped.h>
-#include <sensor_msgs/Imu.h>
-#include <tf/transform_datatypes.h>
- #include <graft/GraftSensor.h>
+#ifndef GRAFT_UPDATE_SCHEDULER_H
+#define GRAFT_UPDATE_SCHEDULER_H
 
-#define SIZE 7  // State size: qw qx qy qz || wx wy wz
+#include <ros/ros.h>
+#include <boost/function.hpp>
+#include <graft/GraftSensor.h>
 
-using namespace Eigen;
-
-class GraftUKFAttitude{
+// Runs the filter update for each update group, either on a timer at the
+// group rate or every time one of the group's topics receives a message.
+class GraftUpdateScheduler{
   public:
-    GraftUKFAttitude();
-    ~GraftUKFAttitude();
-
-	MatrixXd f(MatrixXd x, double dt);
-
-	std::vector<MatrixXd > predict_sigma_points(std::vector<MatrixXd >& sigma_points, double dt);
+    typedef boost::function<void(GraftUpdateGroup&)> UpdateFunction;
 
-	graft::GraftStatePtr getMessageFromState();
+    GraftUpdateScheduler(ros::NodeHandle n, UpdateFunction update);
 
-	graft::GraftStatePtr getMessageFromState(Matrix<double, SIZE, 1>& state, Matrix<double, SIZE, SIZE>& covariance);
+    ~GraftUpdateScheduler();
 
-	double predictAndUpdate();
+    void setGroups(const std::vector<GraftUpdateGroup>& groups);
 
-	void setTopics(std::vector<boost::shared_ptr<GraftSensor> >& topics);
-
-	void setInitialCovariance(std::vector<double>& P);
-
-	void setProcessNoise(std::vector<double>& Q);
-
-	void setAlpha(const double alpha);
-
-	void setKappa(const double kappa);
-
-	void setBeta(const double beta);
-    
   private:
 
-    Matrix<double, SIZE, 1> graft_state_;
-	Matrix<double, SIZE, 1> graft_control_;
-	Matrix<double, SIZE, SIZE> graft_covariance_;
-
-	Matrix<double, SIZE, SIZE> Q_;
+    void timerCallback(const ros::TimerEvent& event, size_t group);
 
-    ros::Time last_update_time_;
-    ros::Time last_imu_time_;
+    void arrivalCallback(size_t group);
 
-    double alpha_;
-    double beta_;
-    double kappa_;
+    ros::NodeHandle n_;
+    UpdateFunction update_;
 
-    std::vector<boost::shared_ptr<GraftSensor> > topics_;
+    std::vector<GraftUpdateGroup> groups_;
+    std::vector<ros::Timer> timers_;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_VELOCITY_MODEL_H
+#define GRAFT_VELOCITY_MODEL_H
+
+#include <cmath>
+#include <Eigen/Dense>
+#include <graft/GraftScalar.h>
+#include <graft/GraftState.h>
+#include <graft/GraftMeasurementSet.h>
+#include <graft/GraftInitialization.h>
+#include <nav_msgs/Odometry.h>
+
+// Planar body velocities: vx, vy, wz
+struct GraftVelocityModel{
+  enum { SIZE = 3 };
+  typedef Eigen::Matrix<GraftScalar, SIZE, 1> StateVector;
+
+  static const char* name(){
+    return "velocity";
+  }
+
+  static void initialState(StateVector& x){
+    x.setZero();
+  }
+
+  static unsigned int requiredInitialization(){
+    return GRAFT_INIT_LINEAR_VELOCITY | GRAFT_INIT_ANGULAR_VELOCITY;
+  }
+
+  // Seeds the state from one measurement, returns the GraftInitialization parts it set
+  template<typename Covariance>
+  static unsigned int initialize(const graft::GraftSensorResidual& meas, StateVector& x, Covariance& P){
+    unsigned int seeded = 0;
+    if(meas.twist_covariance[0] > 1e-20){
+      seedElement(x, P, 0, meas.twist.linear.x, meas.twist_covariance[0]);
+      seeded |= GRAFT_INIT_LINEAR_VELOCITY;
+    }
+    if(meas.twist_covariance[7] > 1e-20){
+      seedElement(x, P, 1, meas.twist.linear.y, meas.twist_covariance[7]);
+      seeded |= GRAFT_INIT_LINEAR_VELOCITY;
+    }
+    if(meas.twist_covariance[35] > 1e-20){
+      seedElement(x, P, 2, meas.twist.angular.z, meas.twist_covariance[35]);
+      seeded |= GRAFT_INIT_ANGULAR_VELOCITY;
+    }
+    return seeded;
+  }
+
+  // Velocities hold, rotation decays to zero each step
+  static StateVector f(const StateVector& x, const double dt){
+    StateVector out;
+    out.setZero();
+    out(0) = x(0);
+    out(1) = x(1);
+    return out;
+  }
+
+  // The newest posterior holds until the next update
+  static StateVector extrapolate(const StateVector& x, const double dt){
+    return x;
+  }
+
+  static void normalize(StateVector& x){
+  }
+
+  // Longest prediction step, 0 for no limit
+  static double maxTimeStep(){
+    return 0.0;
+  }
+
+  static void toMessage(const StateVector& x, graft::GraftState& msg){
+    msg.twist.linear.x = x(0);
+    msg.twist.linear.y = x(1);
+    msg.twist.angular.z = x(2);
+  }
+
+  static void addMeasurements(const graft::GraftSensorResidual& meas, const GraftMeasurementSet::Residuals& residuals, GraftMeasurementSet& measurements){
+    if(meas.twist_covariance[0] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[0], residuals, residualLinearVelocityX);
+    }
+    if(meas.twist_covariance[7] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[7], residuals, residualLinearVelocityY);
+    }
+    if(meas.twist_covariance[35] > 1e-20){
+      measurements.add(meas, meas.twist_covariance[35], residuals, residualAngularVelocityZ);
+    }
+  }
+
+  // Integrates the estimated velocities over dt into the planar pose of odom
+  static void toOdometry(const graft::GraftState& state, const double dt, nav_msgs::Odometry& odom){
+    odom.twist.twist.linear.x = state.twist.linear.x;
+    odom.twist.twist.linear.y = state.twist.linear.y;
+    odom.twist.twist.angular.z = state.twist.angular.z;
+
+    double diff = pow(odom.pose.pose.orientation.w, 2.0)-pow(odom.pose.pose.orientation.z, 2.0);
+    double mult = 2.0*odom.pose.pose.orientation.w*odom.pose.pose.orientation.z;
+    double theta = atan2(mult, diff);
+    if(std::abs(odom.twist.twist.angular.z) < 0.00001){ // There's no (or very little) curvature, apply the straight line model
+      odom.pose.pose.position.x += odom.twist.twist.linear.x*dt*cos(theta)-odom.twist.twist.linear.y*dt*sin(theta);
+      odom.pose.pose.position.y += odom.twist.twist.linear.x*dt*sin(theta)+odom.twist.twist.linear.y*dt*cos(theta);
+    } else { // Calculate components of arc distance and add distances.
+      double curvature_x = odom.twist.twist.linear.x/odom.twist.twist.angular.z;
+      double curvature_y = odom.twist.twist.linear.y/odom.twist.twist.angular.z;
+      double new_theta = theta + odom.twist.twist.angular.z*dt;
+
+      odom.pose.pose.position.x += -curvature_x*sin(theta) + curvature_x*sin(new_theta);
+      odom.pose.pose.position.x += -curvature_y*cos(theta) + curvature_y*cos(new_theta);
+      odom.pose.pose.position.y += curvature_x*cos(theta) - curvature_x*cos(new_theta);
+      odom.pose.pose.position.y += -curvature_y*sin(theta) + curvature_y*sin(new_theta);
+      theta = new_theta;
+    }
+    odom.pose.pose.orientation.z = sin(theta/2.0);
+    odom.pose.pose.orientation.w = cos(theta/2.0);
+  }
+};
+
+#endif
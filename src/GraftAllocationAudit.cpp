@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <graft/GraftAllocationAudit.h>
+#include <cstring>
+
+#ifdef GRAFT_ALLOCATION_AUDIT
+
+#include <errno.h>
+#include <stddef.h>
+#include <Eigen/Core>
+
+// glibc's own allocator, which the interposed functions below forward to
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+// initial-exec, so touching them never allocates the thread's TLS block
+static __thread int stage_ __attribute__((tls_model("initial-exec"))) = GraftAllocationAudit::OTHER;
+static __thread uint64_t allocations_[GraftAllocationAudit::STAGES] __attribute__((tls_model("initial-exec")));
+static __thread uint64_t bytes_[GraftAllocationAudit::STAGES] __attribute__((tls_model("initial-exec")));
+
+static inline void count(const size_t size){
+	allocations_[stage_]++;
+	bytes_[stage_] += size;
+}
+
+extern "C" {
+
+void* malloc(size_t size){
+	count(size);
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t n, size_t size){
+	count(n*size);
+	return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, size_t size){
+	if(size > 0){
+		count(size);
+	}
+	return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size){
+	count(size);
+	return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size){
+	count(size);
+	return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size){
+	if(alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0){
+		return EINVAL;
+	}
+	count(size);
+	void* p = __libc_memalign(alignment, size);
+	if(p == NULL){
+		return ENOMEM;
+	}
+	*ptr = p;
+	return 0;
+}
+
+void free(void* ptr){
+	__libc_free(ptr);
+}
+
+}
+
+static void allowEigenMalloc(const int stage){
+#ifdef GRAFT_ALLOCATION_AUDIT_STRICT
+	Eigen::internal::set_is_malloc_allowed(stage != GraftAllocationAudit::PREDICTION && stage != GraftAllocationAudit::UPDATE);
+#endif
+}
+
+GraftAllocationScope::GraftAllocationScope(const GraftAllocationAudit::Stage stage): previous_(static_cast<GraftAllocationAudit::Stage>(stage_)){
+	enter(stage);
+}
+
+GraftAllocationScope::~GraftAllocationScope(){
+	enter(previous_);
+}
+
+void GraftAllocationScope::enter(const GraftAllocationAudit::Stage stage){
+	stage_ = stage;
+	allowEigenMalloc(stage);
+}
+
+bool GraftAllocationAudit::enabled(){
+	return true;
+}
+
+void GraftAllocationAudit::get(Counts& counts){
+	for(size_t i = 0; i < STAGES; i++){
+		counts.allocations[i] = allocations_[i];
+		counts.bytes[i] = bytes_[i];
+	}
+}
+
+#else
+
+bool GraftAllocationAudit::enabled(){
+	return false;
+}
+
+void GraftAllocationAudit::get(Counts& counts){
+	memset(&counts, 0, sizeof(counts));
+}
+
+#endif
+
+const char* GraftAllocationAudit::name(const Stage stage){
+	switch(stage){
+		case PREDICTION: return "prediction";
+		case MEASUREMENTS: return "measurements";
+		case OBSERVATION: return "observation";
+		case UPDATE: return "update";
+		case OUTPUT: return "output";
+		default: return "other";
+	}
+}
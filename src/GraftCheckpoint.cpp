@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <graft/GraftCheckpoint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+
+
+GraftCheckpoint::GraftCheckpoint(): data_(NULL){
+
+}
+
+GraftCheckpoint::~GraftCheckpoint(){
+	close();
+}
+
+bool GraftCheckpoint::open(const std::string& path){
+	close();
+	path_ = path;
+	int fd = ::open(path_.c_str(), O_CREAT | O_RDWR, 0644);
+	if(fd < 0){
+		ROS_ERROR("Could not open checkpoint %s: %s", path_.c_str(), strerror(errno));
+		return false;
+	}
+	struct stat st;
+	bool valid_size = fstat(fd, &st) == 0 && st.st_size == (off_t)sizeof(GraftCheckpointFile);
+	if(!valid_size && ftruncate(fd, sizeof(GraftCheckpointFile)) != 0){
+		ROS_ERROR("Could not size checkpoint %s: %s", path_.c_str(), strerror(errno));
+		::close(fd);
+		return false;
+	}
+	void* mem = mmap(NULL, sizeof(GraftCheckpointFile), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(mem == MAP_FAILED){
+		ROS_ERROR("Could not map checkpoint %s: %s", path_.c_str(), strerror(errno));
+		return false;
+	}
+	data_ = static_cast<GraftCheckpointFile*>(mem);
+
+	// New file, or written by another version
+	if(!valid_size || data_->magic != GRAFT_CHECKPOINT_MAGIC || data_->version != GRAFT_CHECKPOINT_VERSION){
+		memset(data_, 0, sizeof(GraftCheckpointFile));
+		data_->version = GRAFT_CHECKPOINT_VERSION;
+		data_->magic = GRAFT_CHECKPOINT_MAGIC;
+	}
+	return true;
+}
+
+void GraftCheckpoint::close(){
+	if(data_ != NULL){
+		msync(data_, sizeof(GraftCheckpointFile), MS_SYNC);
+		munmap(data_, sizeof(GraftCheckpointFile));
+		data_ = NULL;
+	}
+}
+
+bool GraftCheckpoint::isOpen(){
+	return data_ != NULL;
+}
+
+const GraftCheckpointSlot* GraftCheckpoint::newestSlot(){
+	const GraftCheckpointSlot* newest = NULL;
+	for(size_t i = 0; i < 2; i++){
+		const GraftCheckpointSlot& slot = data_->slots[i];
+		if(slot.sequence == 0 || (slot.sequence & 1)){
+			continue;
+		}
+		if(newest == NULL || slot.sequence > newest->sequence){
+			newest = &slot;
+		}
+	}
+	return newest;
+}
+
+void GraftCheckpoint::write(const std::string& process_model, const ros::Time& stamp, const std::vector<double>& state,
+                            const std::vector<double>& covariance, const nav_msgs::Odometry& odom,
+                            const std::vector<boost::shared_ptr<GraftSensor> >& topics){
+	if(data_ == NULL || state.size() > 18 || covariance.size() != state.size()*state.size()){
+		return;
+	}
+	// Keep the newest complete slot, overwrite the other
+	uint32_t sequence = (std::max(data_->slots[0].sequence, data_->slots[1].sequence) | 1) + 1;
+	GraftCheckpointSlot& slot = newestSlot() == &data_->slots[0] ? data_->slots[1] : data_->slots[0];
+	__atomic_store_n(&slot.sequence, sequence - 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	slot.size = state.size();
+	slot.stamp_sec = stamp.sec;
+	slot.stamp_nsec = stamp.nsec;
+	memset(slot.process_model, 0, sizeof(slot.process_model));
+	strncpy(slot.process_model, process_model.c_str(), sizeof(slot.process_model) - 1);
+	std::copy(state.begin(), state.end(), slot.state);
+	std::copy(covariance.begin(), covariance.end(), slot.covariance);
+
+	slot.odometry_position[0] = odom.pose.pose.position.x;
+	slot.odometry_position[1] = odom.pose.pose.position.y;
+	slot.odometry_position[2] = odom.pose.pose.position.z;
+	slot.odometry_orientation[0] = odom.pose.pose.orientation.x;
+	slot.odometry_orientation[1] = odom.pose.pose.orientation.y;
+	slot.odometry_orientation[2] = odom.pose.pose.orientation.z;
+	slot.odometry_orientation[3] = odom.pose.pose.orientation.w;
+
+	slot.num_sensors = 0;
+	for(size_t i = 0; i < topics.size() && slot.num_sensors < GRAFT_CHECKPOINT_MAX_SENSORS; i++){
+		ros::Time sensor_stamp;
+		geometry_msgs::Pose pose;
+		if(!topics[i]->getDeltaMemory(sensor_stamp, pose)){
+			continue;
+		}
+		GraftCheckpointSensor& sensor = slot.sensors[slot.num_sensors++];
+		memset(sensor.name, 0, sizeof(sensor.name));
+		strncpy(sensor.name, topics[i]->getName().c_str(), sizeof(sensor.name) - 1);
+		sensor.stamp_sec = sensor_stamp.sec;
+		sensor.stamp_nsec = sensor_stamp.nsec;
+		sensor.position[0] = pose.position.x;
+		sensor.position[1] = pose.position.y;
+		sensor.position[2] = pose.position.z;
+		sensor.orientation[0] = pose.orientation.x;
+		sensor.orientation[1] = pose.orientation.y;
+		sensor.orientation[2] = pose.orientation.z;
+		sensor.orientation[3] = pose.orientation.w;
+	}
+
+	__atomic_store_n(&slot.sequence, sequence, __ATOMIC_RELEASE);
+	msync(data_, sizeof(GraftCheckpointFile), MS_ASYNC);
+}
+
+bool GraftCheckpoint::read(const std::string& process_model, const double max_age, ros::Time& stamp,
+                           std::vector<double>& state, std::vector<double>& covariance, geometry_msgs::Pose& odom_pose,
+                           std::vector<GraftCheckpointMemory>& memory){
+	if(data_ == NULL){
+		return false;
+	}
+	const GraftCheckpointSlot* slot = newestSlot();
+	if(slot == NULL){
+		return false;
+	}
+	if(process_model != std::string(slot->process_model, strnlen(slot->process_model, sizeof(slot->process_model)))){
+		ROS_WARN("Ignoring checkpoint %s of the %s process model.", path_.c_str(), slot->process_model);
+		return false;
+	}
+	if(slot->size > 18){
+		return false;
+	}
+	stamp = ros::Time(slot->stamp_sec, slot->stamp_nsec);
+	double age = (ros::Time::now() - stamp).toSec();
+	if(age < 0.0 || age > max_age){
+		ROS_INFO("Ignoring checkpoint %s written %.1f seconds ago.", path_.c_str(), age);
+		return false;
+	}
+
+	state.assign(slot->state, slot->state + slot->size);
+	covariance.assign(slot->covariance, slot->covariance + slot->size*slot->size);
+
+	odom_pose.position.x = slot->odometry_position[0];
+	odom_pose.position.y = slot->odometry_position[1];
+	odom_pose.position.z = slot->odometry_position[2];
+	odom_pose.orientation.x = slot->odometry_orientation[0];
+	odom_pose.orientation.y = slot->odometry_orientation[1];
+	odom_pose.orientation.z = slot->odometry_orientation[2];
+	odom_pose.orientation.w = slot->odometry_orientation[3];
+
+	memory.clear();
+	for(size_t i = 0; i < slot->num_sensors && i < GRAFT_CHECKPOINT_MAX_SENSORS; i++){
+		const GraftCheckpointSensor& sensor = slot->sensors[i];
+		GraftCheckpointMemory entry;
+		entry.name = std::string(sensor.name, strnlen(sensor.name, sizeof(sensor.name)));
+		entry.stamp = ros::Time(sensor.stamp_sec, sensor.stamp_nsec);
+		entry.pose.position.x = sensor.position[0];
+		entry.pose.position.y = sensor.position[1];
+		entry.pose.position.z = sensor.position[2];
+		entry.pose.orientation.x = sensor.orientation[0];
+		entry.pose.orientation.y = sensor.orientation[1];
+		entry.pose.orientation.z = sensor.orientation[2];
+		entry.pose.orientation.w = sensor.orientation[3];
+		memory.push_back(entry);
+	}
+	return true;
+}
+
+void GraftCheckpoint::restoreMemory(const std::vector<GraftCheckpointMemory>& memory,
+                                    std::vector<boost::shared_ptr<GraftSensor> >& topics){
+	for(size_t i = 0; i < memory.size(); i++){
+		for(size_t j = 0; j < topics.size(); j++){
+			if(topics[j]->getName() == memory[i].name){
+				topics[j]->setDeltaMemory(memory[i].stamp, memory[i].pose);
+			}
+		}
+	}
+}
@@ -0,0 +1,549 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sstream>
+#include <graft/GraftFilterNode.h>
+#include <graft/GraftIMM.h>
+#include <graft/GraftStateCompact.h>
+
+GraftFilterNode::GraftFilterNode(ros::NodeHandle n, ros::NodeHandle pnh): n_(n), pnh_(pnh), manager_(n, pnh),
+                                                                          ready_(false), max_priority_(0), load_pending_(false), load_pending_cycle_time_(0.0), audit_cycles_(0), output_rate_(0.0), publish_tf_(false){
+	for(size_t i = 0; i < GraftAllocationAudit::STAGES; i++){
+		audit_counts_.allocations[i] = 0;
+		audit_counts_.bytes[i] = 0;
+	}
+	audit_report_time_ = ros::WallTime::now();
+}
+
+GraftFilterNode::~GraftFilterNode(){
+	if(realtime_loop_ != NULL){
+		realtime_loop_->stop();
+	}
+	publisher_.stop();
+	if(checkpoint_.isOpen()){
+		writeCheckpoint();
+	}
+
+}
+
+bool GraftFilterNode::init(){
+	// Load parameters
+	manager_.setRealtimeQueue(&realtime_queue_);
+	manager_.loadParameters(topics_, subs_);
+
+	std::vector<GraftIMMMode> imm_modes = manager_.getIMMModes();
+	if(imm_modes.size() > 1){
+		ukf_ = createGraftIMM(manager_.getProcessModel(), imm_modes, manager_.getIMMStayProbability(), manager_.getIMMThreads());
+		ROS_INFO("Running %zu interacting models.", imm_modes.size());
+	} else {
+		if(imm_modes.size() == 1){
+			ROS_WARN("imm_modes has a single mode, running a single filter with process_noise.");
+		}
+		ukf_ = createGraftFilter(manager_.getProcessModel());
+	}
+	if(ukf_ == NULL){
+		ROS_FATAL("Unknown process_model '%s', expected velocity, attitude, absolute or inertial.", manager_.getProcessModel().c_str());
+		return false;
+	}
+
+	state_pub_ = pnh_.advertise<graft::GraftState>("state", 5);
+	compact_state_pub_ = pnh_.advertise<graft::GraftStateCompact>("state_compact", 5);
+	odom_pub_ = n_.advertise<nav_msgs::Odometry>("odom_combined", 5);
+	smoothed_pub_ = n_.advertise<nav_msgs::Odometry>("odom_smoothed", 5);
+	ready_pub_ = pnh_.advertise<std_msgs::Bool>("ready", 1, true);
+	gate_pub_ = pnh_.advertise<graft::GraftGateStatistics>("gate_statistics", 5);
+	recovery_pub_ = pnh_.advertise<graft::GraftRecoveryEvent>("recovery", 5, true);
+	load_pub_ = pnh_.advertise<graft::GraftLoadShedding>("load_shedding", 1, true);
+	realtime_pub_ = pnh_.advertise<graft::GraftRealtimeStatistics>("realtime_statistics", 5);
+
+	publish_tf_ = manager_.getPublishTF();
+	output_rate_ = manager_.getOutputRate();
+
+	if(!manager_.getSharedMemoryName().empty()){
+		shared_state_.open(manager_.getSharedMemoryName());
+	}
+
+	parent_frame_id_ = manager_.getParentFrameID();
+	child_frame_id_ = manager_.getChildFrameID();
+
+	// Set up the E
+	std::vector<double> initial_covariance = manager_.getInitialCovariance();
+	std::vector<double> Q = manager_.getProcessNoise();
+	ukf_->setAlpha(manager_.getAlpha());
+	ukf_->setKappa(manager_.getKappa());
+	ukf_->setBeta(manager_.getBeta());
+	ukf_->setInitialCovariance(initial_covariance);
+	ukf_->setProcessNoise(Q);
+	ukf_->setStateHistorySize(manager_.getStateHistorySize());
+	ukf_->setSmootherLag(manager_.getSmootherLag());
+	ukf_->setTopics(topics_);
+	ukf_->setRecovery(manager_.getRecoveryInflation(), manager_.getMaxRecoveries());
+	ukf_->setRecoveryCallback(boost::bind(&GraftFilterNode::recoveryCallback, this, _1));
+	ukf_->setInitializeFromMeasurements(manager_.getInitializeFromMeasurements(), manager_.getInitializationTimeout());
+	if(!manager_.getFlightRecorderFile().empty() &&
+	   flight_recorder_.open(manager_.getFlightRecorderFile(), manager_.getFlightRecorderSize(), manager_.getProcessModel(), topics_)){
+		ukf_->setFlightRecorder(&flight_recorder_);
+	}
+	odom_.pose.pose.position.x = 0.0;
+	odom_.pose.pose.position.y = 0.0;
+	odom_.pose.pose.position.z = 0.0;
+
+	odom_.pose.pose.orientation.w = 1.0;
+	odom_.pose.pose.orientation.x = 0.0;
+	odom_.pose.pose.orientation.y = 0.0;
+	odom_.pose.pose.orientation.z = 0.0;
+
+	odom_.twist.twist.linear.x = 0.0;
+	odom_.twist.twist.linear.y = 0.0;
+	odom_.twist.twist.linear.z = 0.0;
+	odom_.twist.twist.angular.x = 0.0;
+	odom_.twist.twist.angular.y = 0.0;
+	odom_.twist.twist.angular.z = 0.0;
+
+	if(!manager_.getCheckpointFile().empty() && checkpoint_.open(manager_.getCheckpointFile())){
+		restoreCheckpoint();
+		if(manager_.getCheckpointRate() > 1e-10){
+			checkpoint_timer_ = n_.createTimer(ros::Duration(1.0/manager_.getCheckpointRate()), &GraftFilterNode::checkpointCallback, this);
+		}
+	}
+
+	smoothed_odom_ = odom_; // Integrated separately by the velocity model
+	smoothed_odom_.header.stamp = ros::Time();
+
+	std_msgs::Bool ready;
+	ready.data = ukf_->isReady();
+	ready_pub_.publish(ready);
+	ready_ = ready.data;
+
+	// Tf Broadcaster
+	broadcaster_.reset(new tf::TransformBroadcaster());
+
+	// Query the state at any time
+	state_srv_ = pnh_.advertiseService("get_state", &GraftFilterNode::getStateCallback, this);
+
+	// Tuning without a restart, after 'rosparam load' into this node's namespace
+	reload_srv_ = pnh_.advertiseService("reload_parameters", &GraftFilterNode::reloadParametersCallback, this);
+
+	// Publish estimates off the filter thread
+	publisher_.start(boost::bind(&GraftFilterNode::publishSlot, this, _1));
+
+	// Start an update loop for each update group
+	std::vector<GraftUpdateGroup> groups = manager_.getUpdateGroups();
+	for(size_t i = 0; i < groups.size(); i++){
+		max_priority_ = i == 0 ? groups[i].priority : std::max(max_priority_, groups[i].priority);
+	}
+	shedder_.setDeadline(manager_.getUpdateDeadline());
+	applyLoadLevel(0.0);
+	scheduler_.reset(new GraftUpdateScheduler(n_, boost::bind(&GraftFilterNode::updateCallback, this, _1)));
+	if(manager_.getRealtime()){
+		// The scheduler keeps the groups fused on arrival, their topics are serviced by the loop
+		std::vector<GraftUpdateGroup> arrival_groups;
+		double max_rate = manager_.getUpdateRate();
+		for(size_t i = 0; i < groups.size(); i++){
+			if(groups[i].rate < 1e-10){
+				arrival_groups.push_back(groups[i]);
+			}
+			max_rate = std::max(max_rate, groups[i].rate);
+		}
+		scheduler_->setGroups(arrival_groups);
+		realtime_loop_.reset(new GraftRealtimeLoop(&realtime_queue_, filter_mutex_,
+				boost::bind(&GraftFilterNode::updateCallback, this, _1),
+				boost::bind(&GraftFilterNode::realtimeStatisticsCallback, this, _1)));
+		realtime_loop_->setPriority(manager_.getRealtimePriority());
+		realtime_loop_->setCPU(manager_.getRealtimeCPU());
+		realtime_loop_->setLockMemory(manager_.getRealtimeLockMemory());
+		realtime_loop_->start(groups, manager_.getUpdateRate());
+		publish_timer_ = n_.createTimer(ros::Duration(0.5/std::max(max_rate, 1.0)), &GraftFilterNode::publishCallback, this);
+	} else {
+		scheduler_->setGroups(groups);
+	}
+
+	// Extrapolated output between updates
+	if(output_rate_ > 1e-10){
+		output_timer_ = n_.createTimer(ros::Duration(1.0/output_rate_), &GraftFilterNode::outputCallback, this);
+	}
+	return true;
+}
+
+void GraftFilterNode::setOdometryCallback(OdometryFunction callback){
+	odometry_callback_ = callback;
+}
+
+GraftParameterManager& GraftFilterNode::getParameterManager(){
+	return manager_;
+}
+
+void GraftFilterNode::publishTF(const nav_msgs::Odometry& msg){
+  geometry_msgs::TransformStamped tf;
+  tf.header.stamp = msg.header.stamp;
+  tf.header.frame_id = msg.header.frame_id;
+  tf.child_frame_id = msg.child_frame_id;
+  
+  tf.transform.translation.x = msg.pose.pose.position.x;
+  tf.transform.translation.y = msg.pose.pose.position.y;
+  tf.transform.translation.z = msg.pose.pose.position.z;
+  tf.transform.rotation = msg.pose.pose.orientation;
+  
+  broadcaster_->sendTransform(tf);
+}
+
+bool GraftFilterNode::getStateCallback(graft::GetState::Request& req, graft::GetState::Response& res){
+	ros::Time stamp = req.stamp;
+	if(stamp.isZero()){
+		stamp = ros::Time::now();
+	}
+	boost::mutex::scoped_lock lock(filter_mutex_);
+	graft::GraftStatePtr state = ukf_->getMessageAtTime(stamp);
+	res.success = (state != NULL);
+	if(res.success){
+		res.state = *state;
+		res.state.header.stamp = stamp;
+		res.state.header.frame_id = parent_frame_id_;
+	}
+	return true;
+}
+
+bool GraftFilterNode::reloadParametersCallback(std_srvs::Trigger::Request& req, std_srvs::Trigger::Response& res){
+	// Called from the same callback queue as the updates or under the real-time loop's lock,
+	// so the changes apply between two of them
+	boost::mutex::scoped_lock lock(filter_mutex_);
+	res.success = manager_.reloadParameters(topics_, ukf_->size(), res.message);
+	if(!res.success){
+		ROS_WARN("Not reloading parameters: %s", res.message.c_str());
+		return true;
+	}
+	std::vector<double> Q = manager_.getProcessNoise();
+	ukf_->setProcessNoise(Q);
+	std::vector<GraftIMMMode> imm_modes = manager_.getIMMModes();
+	std::vector<std::vector<double> > mode_Q(imm_modes.size());
+	for(size_t i = 0; i < imm_modes.size(); i++){
+		mode_Q[i] = imm_modes[i].process_noise;
+	}
+	ukf_->setModeProcessNoise(mode_Q);
+	ukf_->setAlpha(manager_.getAlpha());
+	ukf_->setKappa(manager_.getKappa());
+	ukf_->setBeta(manager_.getBeta());
+	ukf_->setRecovery(manager_.getRecoveryInflation(), manager_.getMaxRecoveries());
+	uint8_t level = shedder_.getLevel();
+	shedder_.setDeadline(manager_.getUpdateDeadline());
+	if(level != shedder_.getLevel()){
+		applyLoadLevel(0.0);
+	}
+	res.message = "Reloaded process noise, filter and topic parameters";
+	ROS_INFO("%s", res.message.c_str());
+	return true;
+}
+
+// dt is the time since the last published odometry, for models that integrate the pose
+void GraftFilterNode::publishOdometry(const graft::GraftState& state, const double dt){
+	{
+		boost::mutex::scoped_lock lock(odom_mutex_);
+		odom_.header.stamp = state.header.stamp;
+		odom_.header.frame_id = parent_frame_id_;
+		odom_.child_frame_id = child_frame_id_;
+		ukf_->updateOdometry(state, dt, odom_);
+	}
+	odom_pub_.publish(odom_);
+	if(publish_tf_){
+	  publishTF(odom_);
+	}
+	if(shared_state_.isOpen()){
+		graft::GraftState shared = state;
+		shared.pose = odom_.pose.pose; // Integrated here by the velocity model
+		shared_state_.write(shared, ukf_->size());
+	}
+	if(odometry_callback_){
+		odometry_callback_(odom_);
+	}
+}
+
+void GraftFilterNode::updateCallback(GraftUpdateGroup& group){
+	if(shedder_.getLevel() >= graft::GraftLoadShedding::PRIORITY_ONLY && group.priority < max_priority_){
+		return; // Its messages wait for a later update unless they time out
+	}
+	ros::WallTime start = ros::WallTime::now();
+	GraftAllocationAudit::Counts allocations;
+	GraftAllocationAudit::get(allocations);
+	double dt = ukf_->predictAndUpdate(group.topics);
+	if(checkReady()){
+		GraftPublishSlot* slot = publisher_.acquire();
+		if(slot == NULL){
+			ROS_WARN_THROTTLE(1.0, "Publishing is falling behind the filter, dropping an estimate.");
+		} else {
+			GraftAllocationScope scope(GraftAllocationAudit::OUTPUT);
+			collectUpdate(dt, *slot);
+			publisher_.commit(slot);
+		}
+	}
+	if(GraftAllocationAudit::enabled()){
+		auditAllocations(allocations);
+	}
+	checkLoad((ros::WallTime::now() - start).toSec());
+}
+
+void GraftFilterNode::auditAllocations(const GraftAllocationAudit::Counts& before){
+	GraftAllocationAudit::Counts after;
+	GraftAllocationAudit::get(after);
+	for(size_t i = 0; i < GraftAllocationAudit::STAGES; i++){
+		audit_counts_.allocations[i] += after.allocations[i] - before.allocations[i];
+		audit_counts_.bytes[i] += after.bytes[i] - before.bytes[i];
+	}
+	audit_cycles_++;
+	ros::WallTime now = ros::WallTime::now();
+	if((now - audit_report_time_).toSec() < 10.0){
+		return;
+	}
+	std::stringstream ss;
+	ss << "Allocations per update over " << audit_cycles_ << " updates:";
+	double allocations = 0.0;
+	double bytes = 0.0;
+	for(size_t i = 0; i < GraftAllocationAudit::STAGES; i++){
+		double n = double(audit_counts_.allocations[i])/audit_cycles_;
+		double b = double(audit_counts_.bytes[i])/audit_cycles_;
+		ss << " " << GraftAllocationAudit::name(static_cast<GraftAllocationAudit::Stage>(i)) << " " << n << " (" << b << " bytes)";
+		allocations += n;
+		bytes += b;
+	}
+	ss << ", total " << allocations << " (" << bytes << " bytes)";
+	ROS_INFO_STREAM(ss.str());
+	for(size_t i = 0; i < GraftAllocationAudit::STAGES; i++){
+		audit_counts_.allocations[i] = 0;
+		audit_counts_.bytes[i] = 0;
+	}
+	audit_cycles_ = 0;
+	audit_report_time_ = now;
+}
+
+void GraftFilterNode::collectUpdate(const double dt, GraftPublishSlot& slot){
+	// Stamped with the time of the estimate, not when it is published
+	ukf_->getMessageFromState(slot.state);
+	slot.state.header.stamp = ukf_->getStateTime();
+	slot.dt = dt;
+	bool covariance = shedder_.getLevel() < graft::GraftLoadShedding::NO_COVARIANCE;
+	slot.publish_state = covariance && state_pub_.getNumSubscribers() > 0;
+	slot.publish_compact_state = covariance && compact_state_pub_.getNumSubscribers() > 0;
+	if(slot.publish_compact_state){
+		ukf_->getCompactMessageFromState(slot.compact_state);
+		slot.compact_state.header = slot.state.header;
+	}
+	slot.publish_gate_statistics = covariance && gate_pub_.getNumSubscribers() > 0;
+	if(slot.publish_gate_statistics){
+		getGateStatistics(slot.state.header.stamp, slot.gate_statistics);
+	}
+	slot.publish_odometry = output_rate_ < 1e-10; // Otherwise published by outputCallback
+	slot.publish_load_shedding = false;
+	slot.publish_smoothed_odometry = covariance && smoothed_pub_.getNumSubscribers() > 0 && ukf_->getSmoothedMessage(slot.smoothed_state) &&
+	                                 slot.smoothed_state.header.stamp != last_smoothed_stamp_; // Unchanged without measurements
+	if(slot.publish_smoothed_odometry){
+		last_smoothed_stamp_ = slot.smoothed_state.header.stamp;
+	}
+}
+
+void GraftFilterNode::publishSlot(const GraftPublishSlot& slot){
+	if(slot.publish_state){
+		state_pub_.publish(slot.state);
+	}
+	if(slot.publish_compact_state){
+		compact_state_pub_.publish(slot.compact_state);
+	}
+	if(slot.publish_gate_statistics){
+		gate_pub_.publish(slot.gate_statistics);
+	}
+	if(slot.publish_odometry){
+		publishOdometry(slot.state, slot.dt);
+	}
+	if(slot.publish_smoothed_odometry){
+		publishSmoothedOdometry(slot.smoothed_state);
+	}
+	if(slot.publish_load_shedding){
+		publishLoadShedding(slot.load_shedding);
+	}
+}
+
+void GraftFilterNode::publishSmoothedOdometry(const graft::GraftState& state){
+	double dt = 0.0;
+	if(!smoothed_odom_.header.stamp.isZero()){
+		dt = (state.header.stamp - smoothed_odom_.header.stamp).toSec();
+	}
+	smoothed_odom_.header.stamp = state.header.stamp;
+	smoothed_odom_.header.frame_id = parent_frame_id_;
+	smoothed_odom_.child_frame_id = child_frame_id_;
+	ukf_->updateOdometry(state, dt, smoothed_odom_);
+	smoothed_pub_.publish(smoothed_odom_);
+}
+
+void GraftFilterNode::publishCallback(const ros::TimerEvent& event){
+	graft::GraftRealtimeStatistics statistics;
+	while(realtime_statistics_.pop(statistics)){
+		statistics.header.frame_id = parent_frame_id_;
+		realtime_pub_.publish(statistics);
+	}
+}
+
+void GraftFilterNode::realtimeStatisticsCallback(const graft::GraftRealtimeStatistics& statistics){
+	realtime_statistics_.push(statistics); // A report is dropped if publishing falls behind
+}
+
+void GraftFilterNode::checkLoad(const double cycle_time){
+	if(shedder_.addCycle(cycle_time)){
+		applyLoadLevel(cycle_time);
+	} else if(load_pending_){
+		applyLoadLevel(load_pending_cycle_time_);
+	}
+}
+
+void GraftFilterNode::applyLoadLevel(const double cycle_time){
+	uint8_t level = shedder_.getLevel();
+	ukf_->setMeanOnlyPrediction(level >= graft::GraftLoadShedding::MEAN_ONLY);
+	// Published and logged off the update thread, retried after the next update if no slot is free
+	GraftPublishSlot* slot = publisher_.acquire();
+	load_pending_ = slot == NULL;
+	load_pending_cycle_time_ = cycle_time;
+	if(slot == NULL){
+		return;
+	}
+	slot->publish_state = false;
+	slot->publish_compact_state = false;
+	slot->publish_gate_statistics = false;
+	slot->publish_odometry = false;
+	slot->publish_smoothed_odometry = false;
+	slot->publish_load_shedding = true;
+	slot->load_shedding.header.stamp = ros::Time::now();
+	slot->load_shedding.level = level;
+	slot->load_shedding.cycle_time = cycle_time;
+	slot->load_shedding.deadline = shedder_.getDeadline();
+	publisher_.commit(slot);
+}
+
+void GraftFilterNode::publishLoadShedding(const graft::GraftLoadShedding& load_shedding){
+	static const char* names[] = {"nominal", "no covariance", "priority only", "mean only"};
+	if(load_shedding.cycle_time > 0.0){
+		ROS_WARN("Update took %.4f seconds against a deadline of %.4f, load shedding is now %s.",
+		         load_shedding.cycle_time, load_shedding.deadline, names[load_shedding.level]);
+	}
+	graft::GraftLoadShedding msg = load_shedding;
+	msg.header.frame_id = parent_frame_id_;
+	load_pub_.publish(msg);
+}
+
+void GraftFilterNode::outputCallback(const ros::TimerEvent& event){
+	if(!ready_){
+		return;
+	}
+	GraftPublishSlot* slot = publisher_.acquire();
+	if(slot == NULL){
+		ROS_WARN_THROTTLE(1.0, "Publishing is falling behind the output rate, dropping an estimate.");
+		return;
+	}
+	ros::Time now = ros::Time::now();
+	bool valid;
+	{
+		boost::mutex::scoped_lock lock(filter_mutex_);
+		valid = ukf_->getMessageAtTime(now, slot->state);
+	}
+	slot->state.header.stamp = now; // Extrapolated to now
+	slot->dt = 0.0;
+	if(!last_output_time_.isZero()){
+		slot->dt = (now - last_output_time_).toSec();
+	}
+	slot->publish_state = false;
+	slot->publish_compact_state = false;
+	slot->publish_gate_statistics = false;
+	slot->publish_smoothed_odometry = false;
+	slot->publish_load_shedding = false;
+	slot->publish_odometry = valid;
+	if(valid){
+		last_output_time_ = now;
+	}
+	publisher_.commit(slot); // Returns the slot even if there is nothing to publish
+}
+
+bool GraftFilterNode::checkReady(){
+	if(ready_ != ukf_->isReady()){ // Initialized, or restarting after repeated recoveries
+		ready_ = ukf_->isReady();
+		std_msgs::Bool ready;
+		ready.data = ready_;
+		ready_pub_.publish(ready);
+	}
+	return ready_;
+}
+
+void GraftFilterNode::getGateStatistics(const ros::Time& stamp, graft::GraftGateStatistics& msg){
+	msg.header.stamp = stamp;
+	msg.header.frame_id = parent_frame_id_;
+	msg.topics.resize(topics_.size());
+	msg.accepted.resize(topics_.size());
+	msg.rejected.resize(topics_.size());
+	msg.normalized_innovation.resize(topics_.size());
+	for(size_t i = 0; i < topics_.size(); i++){
+		const GraftInnovationGate& gate = topics_[i]->getGate();
+		msg.topics[i] = topics_[i]->getName();
+		msg.accepted[i] = gate.getAccepted();
+		msg.rejected[i] = gate.getRejected();
+		msg.normalized_innovation[i] = gate.getLastNIS();
+	}
+}
+
+void GraftFilterNode::recoveryCallback(const graft::GraftRecoveryEvent& event){
+	graft::GraftRecoveryEvent msg = event;
+	msg.header.frame_id = parent_frame_id_;
+	recovery_pub_.publish(msg);
+}
+
+void GraftFilterNode::restoreCheckpoint(){
+	ros::Time stamp;
+	std::vector<double> state, covariance;
+	geometry_msgs::Pose odom_pose;
+	std::vector<GraftCheckpointMemory> memory;
+	if(!checkpoint_.read(manager_.getProcessModel(), manager_.getCheckpointMaxAge(), stamp, state, covariance, odom_pose, memory)){
+		return;
+	}
+	if(!ukf_->restorePosterior(stamp, state, covariance)){
+		ROS_WARN("Checkpoint %s does not fit the %s filter, starting from the initial state.", manager_.getCheckpointFile().c_str(), manager_.getProcessModel().c_str());
+		return;
+	}
+	// Only a restored posterior may pair with the sensors' previous messages
+	odom_.pose.pose = odom_pose;
+	GraftCheckpoint::restoreMemory(memory, topics_);
+	ROS_INFO("Restored the state from checkpoint %s written %.1f seconds ago.", manager_.getCheckpointFile().c_str(), (ros::Time::now() - stamp).toSec());
+}
+
+void GraftFilterNode::writeCheckpoint(){
+	boost::mutex::scoped_lock lock(filter_mutex_);
+	std::vector<double> state, covariance;
+	if(!ukf_->getPosterior(state, covariance)){
+		return;
+	}
+	boost::mutex::scoped_lock odom_lock(odom_mutex_);
+	checkpoint_.write(manager_.getProcessModel(), ros::Time::now(), state, covariance, odom_, topics_);
+}
+
+void GraftFilterNode::checkpointCallback(const ros::TimerEvent& event){
+	writeCheckpoint();
+}
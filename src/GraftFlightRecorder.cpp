@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <graft/GraftFlightRecorder.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+
+
+GraftFlightRecorder::GraftFlightRecorder(): size_(0), header_(NULL), ring_(NULL){
+
+}
+
+GraftFlightRecorder::~GraftFlightRecorder(){
+	close();
+}
+
+static void copyName(char* dest, const std::string& name){
+	memset(dest, 0, GRAFT_FLIGHT_RECORDER_NAME);
+	strncpy(dest, name.c_str(), GRAFT_FLIGHT_RECORDER_NAME - 1);
+}
+
+bool GraftFlightRecorder::open(const std::string& path, const size_t capacity, const std::string& process_model,
+                               const std::vector<boost::shared_ptr<GraftSensor> >& topics){
+	close();
+	path_ = path;
+	GraftFlightRecorderHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = GRAFT_FLIGHT_RECORDER_MAGIC;
+	header.version = GRAFT_FLIGHT_RECORDER_VERSION;
+	header.capacity = capacity & ~uint64_t(7);
+	header.topics = std::min<size_t>(topics.size(), GRAFT_FLIGHT_RECORDER_TOPICS);
+	copyName(header.process_model, process_model);
+	for(size_t i = 0; i < header.topics; i++){
+		copyName(header.topic_names[i], topics[i]->getName());
+	}
+	if(topics.size() > GRAFT_FLIGHT_RECORDER_TOPICS){
+		ROS_WARN("The flight recorder only records the first %d topics.", GRAFT_FLIGHT_RECORDER_TOPICS);
+	}
+
+	int fd = ::open(path_.c_str(), O_CREAT | O_RDWR, 0644);
+	if(fd < 0){
+		ROS_ERROR("Could not open flight recorder %s: %s", path_.c_str(), strerror(errno));
+		return false;
+	}
+	size_t size = sizeof(GraftFlightRecorderHeader) + header.capacity;
+	struct stat st;
+	bool valid_size = fstat(fd, &st) == 0 && st.st_size == (off_t)size;
+	if(!valid_size && ftruncate(fd, size) != 0){
+		ROS_ERROR("Could not size flight recorder %s: %s", path_.c_str(), strerror(errno));
+		::close(fd);
+		return false;
+	}
+	// Populated, so the updates do not fault the pages in
+	void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+	::close(fd);
+	if(mem == MAP_FAILED){
+		ROS_ERROR("Could not map flight recorder %s: %s", path_.c_str(), strerror(errno));
+		return false;
+	}
+	size_ = size;
+	header_ = static_cast<GraftFlightRecorderHeader*>(mem);
+	ring_ = static_cast<char*>(mem) + sizeof(GraftFlightRecorderHeader);
+
+	// Continue the ring of the previous run if its records mean the same
+	bool same = valid_size && header_->magic == header.magic && header_->version == header.version &&
+	            header_->capacity == header.capacity && header_->head <= header.capacity &&
+	            header_->topics == header.topics &&
+	            memcmp(header_->process_model, header.process_model, sizeof(header.process_model)) == 0 &&
+	            memcmp(header_->topic_names, header.topic_names, sizeof(header.topic_names)) == 0;
+	if(!same){
+		memset(mem, 0, size);
+		header.magic = 0;
+		memcpy(header_, &header, sizeof(header));
+		__atomic_store_n(&header_->magic, GRAFT_FLIGHT_RECORDER_MAGIC, __ATOMIC_RELEASE);
+	}
+	ROS_INFO("Recording updates to %s (%lu bytes).", path_.c_str(), (unsigned long)header.capacity);
+	return true;
+}
+
+void GraftFlightRecorder::close(){
+	if(header_ != NULL){
+		msync(header_, size_, MS_SYNC);
+		munmap(header_, size_);
+		header_ = NULL;
+		ring_ = NULL;
+	}
+}
+
+bool GraftFlightRecorder::isOpen(){
+	return header_ != NULL;
+}
+
+GraftFlightRecordHeader* GraftFlightRecorder::reserve(const uint32_t type, const size_t body){
+	size_t size = (sizeof(GraftFlightRecordHeader) + body + 7) & ~size_t(7);
+	if(header_ == NULL || size > header_->capacity){
+		return NULL;
+	}
+	uint64_t head = header_->head;
+	if(head + size > header_->capacity){ // Records older than those at the end are overwritten first
+		head = 0;
+	}
+	GraftFlightRecordHeader* record = reinterpret_cast<GraftFlightRecordHeader*>(ring_ + head);
+	__atomic_store_n(&record->magic, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	record->size = size;
+	record->sequence = header_->sequence;
+	record->type = type;
+	record->reserved = 0;
+	header_->head = head + size;
+	header_->sequence++;
+	return record;
+}
+
+void GraftFlightRecorder::commit(GraftFlightRecordHeader* record){
+	__atomic_store_n(&record->magic, GRAFT_FLIGHT_RECORD_MAGIC, __ATOMIC_RELEASE);
+}
+
+void GraftFlightRecorder::writeMeasurement(const uint32_t topic, const graft::GraftSensorResidual& z){
+	GraftFlightRecordHeader* record = reserve(GRAFT_FLIGHT_MEASUREMENT, sizeof(GraftFlightMeasurement));
+	if(record == NULL){
+		return;
+	}
+	GraftFlightMeasurement& m = *reinterpret_cast<GraftFlightMeasurement*>(record + 1);
+	m.topic = topic;
+	m.reserved = 0;
+	m.stamp_sec = z.header.stamp.sec;
+	m.stamp_nsec = z.header.stamp.nsec;
+	m.pose[0] = z.pose.position.x;
+	m.pose[1] = z.pose.position.y;
+	m.pose[2] = z.pose.position.z;
+	m.pose[3] = z.pose.orientation.x;
+	m.pose[4] = z.pose.orientation.y;
+	m.pose[5] = z.pose.orientation.z;
+	m.pose[6] = z.pose.orientation.w;
+	m.twist[0] = z.twist.linear.x;
+	m.twist[1] = z.twist.linear.y;
+	m.twist[2] = z.twist.linear.z;
+	m.twist[3] = z.twist.angular.x;
+	m.twist[4] = z.twist.angular.y;
+	m.twist[5] = z.twist.angular.z;
+	m.accel[0] = z.accel.x;
+	m.accel[1] = z.accel.y;
+	m.accel[2] = z.accel.z;
+	memcpy(m.pose_covariance, &z.pose_covariance[0], sizeof(m.pose_covariance));
+	memcpy(m.twist_covariance, &z.twist_covariance[0], sizeof(m.twist_covariance));
+	memcpy(m.accel_covariance, &z.accel_covariance[0], sizeof(m.accel_covariance));
+	commit(record);
+}
+
+void GraftFlightRecorder::writeCycle(const GraftFlightCycle& cycle, const GraftScalar* state, const GraftScalar* covariance){
+	size_t n = cycle.size;
+	GraftFlightRecordHeader* record = reserve(GRAFT_FLIGHT_CYCLE, sizeof(GraftFlightCycle) + (n + n*n)*sizeof(double));
+	if(record == NULL){
+		return;
+	}
+	GraftFlightCycle& c = *reinterpret_cast<GraftFlightCycle*>(record + 1);
+	c = cycle;
+	double* out = reinterpret_cast<double*>(&c + 1);
+	for(size_t i = 0; i < n; i++){
+		out[i] = state[i];
+	}
+	out += n;
+	for(size_t i = 0; i < n*n; i++){
+		out[i] = covariance[i];
+	}
+	commit(record);
+}
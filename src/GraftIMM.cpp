@@ -0,0 +1,437 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <graft/GraftIMM.h>
+#include <graft/GraftVelocityModel.h>
+#include <graft/GraftAttitudeModel.h>
+#include <graft/GraftAbsoluteModel.h>
+#include <graft/GraftInertialModel.h>
+
+template<class ProcessModel>
+GraftIMM<ProcessModel>::GraftIMM(const std::vector<GraftIMMMode>& modes, const double stay_probability, const bool threads):
+                                 most_probable_(0), transition_(modes.size(), modes.size()), probabilities_(modes.size()),
+                                 predicted_probabilities_(modes.size()), mixing_weights_(modes.size()), log_likelihoods_(modes.size()),
+                                 mixed_states_(modes.size()), mixed_covariances_(modes.size()), mixed_(true), cycle_topics_(NULL), dts_(modes.size()),
+                                 consumed_(modes.size()), cycle_(0), pending_(0)
+{
+	size_t n = modes.size();
+	double total = 0.0;
+	for(size_t i = 0; i < n; i++){
+		total += std::max(modes[i].probability, 0.0);
+	}
+	for(size_t i = 0; i < n; i++){
+		std::vector<double> Q = modes[i].process_noise;
+		if(Q.size() != SIZE && Q.size() != SIZE*SIZE){
+			ROS_ERROR("imm_modes/%s/process_noise is size %zu, expected %d or %d for the %s model.", modes[i].name.c_str(), Q.size(), SIZE, SIZE*SIZE, ProcessModel::name());
+		}
+		modes_.push_back(boost::shared_ptr<Mode>(new Mode()));
+		modes_[i]->setProcessNoise(Q);
+		modes_[i]->setIMMMode(&gate_mutex_);
+		names_.push_back(modes[i].name);
+		probabilities_[i] = total > 0.0 ? std::max(modes[i].probability, 0.0)/total : 1.0/n;
+	}
+	predicted_probabilities_ = probabilities_;
+
+	transition_.setConstant(n > 1 ? (1.0 - stay_probability)/(n - 1) : 0.0);
+	transition_.diagonal().setConstant(n > 1 ? stay_probability : 1.0);
+
+	if(threads && n > 1 && boost::thread::hardware_concurrency() > 1){
+		for(size_t i = 1; i < n; i++){
+			workers_.create_thread(boost::bind(&GraftIMM::work, this, i));
+		}
+	}
+}
+
+template<class ProcessModel>
+GraftIMM<ProcessModel>::~GraftIMM(){
+	workers_.interrupt_all();
+	workers_.join_all();
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::work(const size_t i){
+	unsigned long cycle = 0;
+	try{
+		while(true){
+			{
+				boost::unique_lock<boost::mutex> lock(work_mutex_);
+				while(cycle_ == cycle){
+					work_started_.wait(lock);
+				}
+				cycle = cycle_;
+			}
+			updateMode(i);
+			boost::unique_lock<boost::mutex> lock(work_mutex_);
+			if(--pending_ == 0){
+				work_done_.notify_one();
+			}
+		}
+	} catch(boost::thread_interrupted&){
+		// Stopped
+	}
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::updateMode(const size_t i){
+	bool consumed = false;
+	dts_[i] = modes_[i]->update(t_, *cycle_topics_, z_, consumed);
+	consumed_[i] = consumed;
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::combine(const std::vector<double>& weights, StateVector& state, CovarianceMatrix& covariance){
+	state.setZero();
+	for(size_t i = 0; i < modes_.size(); i++){
+		state += GraftScalar(weights[i])*modes_[i]->getState();
+	}
+	ProcessModel::normalize(state);
+	covariance.setZero();
+	for(size_t i = 0; i < modes_.size(); i++){
+		if(weights[i] <= 0.0){
+			continue;
+		}
+		StateVector spread = modes_[i]->getState() - state;
+		covariance += GraftScalar(weights[i])*(modes_[i]->getCovariance() + spread*spread.transpose());
+	}
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::mix(){
+	size_t n = modes_.size();
+	for(size_t j = 0; j < n; j++){
+		predicted_probabilities_[j] = 0.0;
+		for(size_t i = 0; i < n; i++){
+			predicted_probabilities_[j] += transition_(i,j)*probabilities_[i];
+		}
+	}
+	for(size_t j = 0; j < n; j++){
+		for(size_t i = 0; i < n; i++){
+			if(predicted_probabilities_[j] > 0.0){
+				mixing_weights_[i] = transition_(i,j)*probabilities_[i]/predicted_probabilities_[j];
+			} else {
+				mixing_weights_[i] = i == j ? 1.0 : 0.0;
+			}
+		}
+		combine(mixing_weights_, mixed_states_[j], mixed_covariances_[j]);
+	}
+	for(size_t j = 0; j < n; j++){
+		modes_[j]->setPosterior(modes_[j]->getStateTime(), mixed_states_[j], mixed_covariances_[j]);
+	}
+	mixed_ = true;
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::updateProbabilities(){
+	// Without a likelihood from every mode there is nothing to tell them apart
+	double max_log_likelihood = -std::numeric_limits<double>::infinity();
+	for(size_t i = 0; i < modes_.size(); i++){
+		if(!modes_[i]->getLogLikelihood(log_likelihoods_[i])){
+			probabilities_ = predicted_probabilities_;
+			return;
+		}
+		max_log_likelihood = std::max(max_log_likelihood, log_likelihoods_[i]);
+	}
+	double total = 0.0;
+	for(size_t i = 0; i < modes_.size(); i++){
+		// Relative to the most likely, so the largest term is 1 and none overflow
+		probabilities_[i] = predicted_probabilities_[i]*std::exp(log_likelihoods_[i] - max_log_likelihood);
+		total += probabilities_[i];
+	}
+	if(!(total > 0.0)){
+		probabilities_ = predicted_probabilities_;
+		return;
+	}
+	for(size_t i = 0; i < modes_.size(); i++){
+		probabilities_[i] /= total;
+	}
+}
+
+template<class ProcessModel>
+double GraftIMM<ProcessModel>::predictAndUpdate(){
+	return predictAndUpdate(topics_);
+}
+
+template<class ProcessModel>
+double GraftIMM<ProcessModel>::predictAndUpdate(std::vector<boost::shared_ptr<GraftSensor> >& topics){
+	if(topics.size() == 0 || topics[0] == NULL){
+		return 0;
+	}
+	if(!mixed_){
+		mix();
+	}
+	// The modes test the same gates, only the one most likely to fit counts the tests
+	size_t recording = std::max_element(predicted_probabilities_.begin(), predicted_probabilities_.end()) - predicted_probabilities_.begin();
+	for(size_t i = 0; i < modes_.size(); i++){
+		modes_[i]->setRecordGates(i == recording);
+	}
+
+	Mode::readMeasurements(topics, z_);
+	t_ = ros::Time::now();
+	cycle_topics_ = &topics;
+	if(workers_.size() > 0){
+		{
+			boost::unique_lock<boost::mutex> lock(work_mutex_);
+			pending_ = modes_.size() - 1;
+			cycle_++;
+		}
+		work_started_.notify_all();
+		updateMode(0);
+		boost::unique_lock<boost::mutex> lock(work_mutex_);
+		while(pending_ > 0){
+			work_done_.wait(lock);
+		}
+	} else {
+		for(size_t i = 0; i < modes_.size(); i++){
+			updateMode(i);
+		}
+	}
+	cycle_topics_ = NULL;
+
+	bool consumed = false;
+	double dt = 0.0;
+	bool ready = true;
+	ros::Time stamp;
+	for(size_t i = 0; i < modes_.size(); i++){
+		consumed = consumed || consumed_[i];
+		dt = std::max(dt, dts_[i]);
+		ready = ready && modes_[i]->isReady();
+		stamp = std::max(stamp, modes_[i]->getStateTime());
+	}
+	if(consumed){
+		for(size_t i = 0; i < topics.size(); i++){
+			topics[i]->clearMessage();
+		}
+	}
+	if(!ready || (combined_.isReady() && stamp == combined_.getStateTime())){
+		return dt; // No mode has a new estimate
+	}
+
+	updateProbabilities();
+	size_t most_probable = std::max_element(probabilities_.begin(), probabilities_.end()) - probabilities_.begin();
+	if(most_probable != most_probable_){
+		ROS_INFO("IMM mode %s is now the most probable (%.3f).", names_[most_probable].c_str(), probabilities_[most_probable]);
+		most_probable_ = most_probable;
+	}
+	StateVector state;
+	CovarianceMatrix covariance;
+	combine(probabilities_, state, covariance);
+	combined_.setPosterior(stamp, state, covariance);
+	mixed_ = false;
+	return dt;
+}
+
+template<class ProcessModel>
+graft::GraftStatePtr GraftIMM<ProcessModel>::getMessageFromState(){
+	return combined_.getMessageFromState();
+}
+
+template<class ProcessModel>
+graft::GraftStateCompactPtr GraftIMM<ProcessModel>::getCompactMessageFromState(){
+	return combined_.getCompactMessageFromState();
+}
+
+template<class ProcessModel>
+graft::GraftStatePtr GraftIMM<ProcessModel>::getMessageAtTime(const ros::Time& stamp){
+	return combined_.getMessageAtTime(stamp);
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::getMessageFromState(graft::GraftState& msg){
+	combined_.getMessageFromState(msg);
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::getCompactMessageFromState(graft::GraftStateCompact& msg){
+	combined_.getCompactMessageFromState(msg);
+}
+
+template<class ProcessModel>
+bool GraftIMM<ProcessModel>::getMessageAtTime(const ros::Time& stamp, graft::GraftState& msg){
+	return combined_.getMessageAtTime(stamp, msg);
+}
+
+template<class ProcessModel>
+ros::Time GraftIMM<ProcessModel>::getStateTime(){
+	return combined_.getStateTime();
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::setTopics(std::vector<boost::shared_ptr<GraftSensor> >& topics){
+	topics_ = topics;
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::setInitialCovariance(std::vector<double>& P){
+	for(size_t i = 0; i < modes_.size(); i++){
+		modes_[i]->setInitialCovariance(P);
+	}
+	combined_.setInitialCovariance(P);
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::setProcessNoise(std::vector<double>& Q){
+	combined_.setProcessNoise(Q);
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::setModeProcessNoise(std::vector<std::vector<double> >& Q){
+	for(size_t i = 0; i < modes_.size() && i < Q.size(); i++){
+		modes_[i]->setProcessNoise(Q[i]);
+	}
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::setAlpha(const double alpha){
+	for(size_t i = 0; i < modes_.size(); i++){
+		modes_[i]->setAlpha(alpha);
+	}
+	combined_.setAlpha(alpha);
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::setKappa(const double kappa){
+	for(size_t i = 0; i < modes_.size(); i++){
+		modes_[i]->setKappa(kappa);
+	}
+	combined_.setKappa(kappa);
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::setBeta(const double beta){
+	for(size_t i = 0; i < modes_.size(); i++){
+		modes_[i]->setBeta(beta);
+	}
+	combined_.setBeta(beta);
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::setStateHistorySize(const size_t size){
+	combined_.setStateHistorySize(size); // Only the combined estimate is queried
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::setInitializeFromMeasurements(const bool initialize, const double timeout){
+	for(size_t i = 0; i < modes_.size(); i++){
+		modes_[i]->setInitializeFromMeasurements(initialize, timeout);
+	}
+	combined_.setInitializeFromMeasurements(initialize, timeout);
+}
+
+template<class ProcessModel>
+bool GraftIMM<ProcessModel>::isReady(){
+	return combined_.isReady();
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::setRecovery(const double inflation, const int max_recoveries){
+	for(size_t i = 0; i < modes_.size(); i++){
+		modes_[i]->setRecovery(inflation, max_recoveries);
+	}
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::setRecoveryCallback(RecoveryFunction callback){
+	for(size_t i = 0; i < modes_.size(); i++){
+		modes_[i]->setRecoveryCallback(callback);
+	}
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::setMeanOnlyPrediction(const bool mean_only){
+	for(size_t i = 0; i < modes_.size(); i++){
+		modes_[i]->setMeanOnlyPrediction(mean_only);
+	}
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::setFlightRecorder(GraftFlightRecorder* recorder){
+	if(recorder != NULL){
+		ROS_WARN("The flight recorder is not supported with imm_modes, not recording.");
+	}
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::setSmootherLag(const size_t lag){
+	if(lag > 0){
+		ROS_WARN("smoother_lag is not supported with imm_modes, not smoothing.");
+	}
+}
+
+template<class ProcessModel>
+bool GraftIMM<ProcessModel>::getSmoothedMessage(graft::GraftState& msg){
+	return false;
+}
+
+template<class ProcessModel>
+bool GraftIMM<ProcessModel>::getPosterior(std::vector<double>& state, std::vector<double>& covariance){
+	return combined_.getPosterior(state, covariance);
+}
+
+template<class ProcessModel>
+bool GraftIMM<ProcessModel>::restorePosterior(const ros::Time& stamp, const std::vector<double>& state, const std::vector<double>& covariance){
+	if(!combined_.restorePosterior(stamp, state, covariance)){
+		return false;
+	}
+	for(size_t i = 0; i < modes_.size(); i++){
+		modes_[i]->setPosterior(combined_.getStateTime(), combined_.getState(), combined_.getCovariance());
+	}
+	mixed_ = true;
+	return true;
+}
+
+template<class ProcessModel>
+size_t GraftIMM<ProcessModel>::size(){
+	return SIZE;
+}
+
+template<class ProcessModel>
+void GraftIMM<ProcessModel>::updateOdometry(const graft::GraftState& state, const double dt, nav_msgs::Odometry& odom){
+	combined_.updateOdometry(state, dt, odom);
+}
+
+template class GraftIMM<GraftVelocityModel>;
+template class GraftIMM<GraftAttitudeModel>;
+template class GraftIMM<GraftAbsoluteModel>;
+template class GraftIMM<GraftInertialModel>;
+
+boost::shared_ptr<GraftFilter> createGraftIMM(const std::string& process_model, const std::vector<GraftIMMMode>& modes, const double stay_probability, const bool threads){
+	if(process_model == GraftVelocityModel::name()){
+		return boost::shared_ptr<GraftFilter>(new GraftIMM<GraftVelocityModel>(modes, stay_probability, threads));
+	} else if(process_model == GraftAttitudeModel::name()){
+		return boost::shared_ptr<GraftFilter>(new GraftIMM<GraftAttitudeModel>(modes, stay_probability, threads));
+	} else if(process_model == GraftAbsoluteModel::name()){
+		return boost::shared_ptr<GraftFilter>(new GraftIMM<GraftAbsoluteModel>(modes, stay_probability, threads));
+	} else if(process_model == GraftInertialModel::name()){
+		return boost::shared_ptr<GraftFilter>(new GraftIMM<GraftInertialModel>(modes, stay_probability, threads));
+	}
+	return boost::shared_ptr<GraftFilter>();
+}
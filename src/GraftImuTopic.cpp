@@ -34,7 +34,7 @@
  #include <graft/GraftImuTopic.h>
 
 
-GraftImuTopic::GraftImuTopic(){
+GraftImuTopic::GraftImuTopic(): staged_timeout_(1.0){
   for( int i=0; i<9; i++ ) {
     orientation_covariance_[i] = 0.0;
   	angular_velocity_covariance_[i] = 0.0;
@@ -48,6 +48,94 @@ GraftImuTopic::~GraftImuTopic(){
 
 void GraftImuTopic::callback(const sensor_msgs::Imu::ConstPtr& msg){
 	msg_ = msg;
+	notifyArrival();
+}
+
+void GraftImuTopic::configure(ros::NodeHandle& tnh){
+	// Check how to use this sensor
+	bool absolute_orientation, delta_orientation, use_velocities, use_accelerations;
+	tnh.param<bool>("absolute_orientation", absolute_orientation, false);
+	tnh.param<bool>("delta_orientation", delta_orientation, false);
+	tnh.param<bool>("use_velocities", use_velocities, false);
+	tnh.param<bool>("use_accelerations", use_accelerations, false);
+
+	// Check for incompatible usage
+	if(absolute_orientation == true){
+		delta_orientation = false; // Should not use for both absolute position and velocity
+	}
+	if(delta_orientation == true){
+		use_velocities = false; // Should not use both estimated and reported velocities
+	}
+
+	// Apply to sensor
+	//useAbsoluteOrientation(absolute_orientation);
+	useDeltaOrientation(delta_orientation);
+	//useVelocities(use_velocities);
+	//useAccelerations(use_accelerations);
+  configureTuning(tnh);
+
+  ROS_INFO("Abs orientation: %d\nDelta orientation: %d\nUse Vel: %d\nTimeout: %.3f", absolute_orientation, delta_orientation, use_velocities, timeout_.toSec());
+}
+
+void GraftImuTopic::stageTuning(ros::NodeHandle& tnh){
+  tnh.param<double>("timeout", staged_timeout_, 1.0);
+
+  // Set covariances, all zero reads them from the message
+  boost::array<double, 9>& orientation_covariance = staged_orientation_covariance_;
+  orientation_covariance.assign(0.0);
+  XmlRpc::XmlRpcValue xml_orientation_covariance;
+  if (tnh.getParam("override_orientation_covariance", xml_orientation_covariance)){
+  	if(xml_orientation_covariance.size() == 9){
+	    for(size_t i = 0; i < xml_orientation_covariance.size(); i++){
+	      std::stringstream ss; // Convert the list element into doubles
+	      ss << xml_orientation_covariance[i];
+	      ss >> orientation_covariance[i] ? orientation_covariance[i] : 0;
+	    }
+    } else {
+    	ROS_WARN("%s/override_orientation_covariance parameter requires 9 elements, skipping.", tnh.getNamespace().c_str());
+    }
+  }
+
+  boost::array<double, 9>& angular_velocity_covariance = staged_angular_velocity_covariance_;
+  angular_velocity_covariance.assign(0.0);
+  XmlRpc::XmlRpcValue xml_angular_velocity_covariance;
+  if (tnh.getParam("override_angular_velocity_covariance", xml_angular_velocity_covariance)){
+  	if(xml_angular_velocity_covariance.size() == 9){
+	    for(size_t i = 0; i < xml_angular_velocity_covariance.size(); i++){
+	      std::stringstream ss; // Convert the list element into doubles
+	      ss << xml_angular_velocity_covariance[i];
+	      ss >> angular_velocity_covariance[i] ? angular_velocity_covariance[i] : 0;
+	    }
+    } else {
+    	ROS_WARN("%s/override_angular_velocity_covariance parameter requires 9 elements, skipping.", tnh.getNamespace().c_str());
+    }
+  }
+
+  boost::array<double, 9>& linear_acceleration_covariance = staged_linear_acceleration_covariance_;
+  linear_acceleration_covariance.assign(0.0);
+  XmlRpc::XmlRpcValue xml_linear_acceleration_covariance;
+  if (tnh.getParam("override_linear_acceleration_covariance", xml_linear_acceleration_covariance)){
+  	if(xml_linear_acceleration_covariance.size() == 9){
+	    for(size_t i = 0; i < xml_linear_acceleration_covariance.size(); i++){
+	      std::stringstream ss; // Convert the list element into doubles
+	      ss << xml_linear_acceleration_covariance[i];
+	      ss >> linear_acceleration_covariance[i] ? linear_acceleration_covariance[i] : 0;
+	    }
+    } else {
+    	ROS_WARN("%s/override_linear_acceleration_covariance parameter requires 9 elements, skipping.", tnh.getNamespace().c_str());
+    }
+  }
+}
+
+void GraftImuTopic::commitTuning(){
+  setTimeout(staged_timeout_);
+  setOrientationCovariance(staged_orientation_covariance_);
+  setAngularVelocityCovariance(staged_angular_velocity_covariance_);
+  setLinearAccelerationCovariance(staged_linear_acceleration_covariance_);
+}
+
+ros::Subscriber GraftImuTopic::subscribe(ros::NodeHandle& n, const std::string& topic, const uint32_t queue_size){
+	return n.subscribe(topic, queue_size, &GraftImuTopic::callback, this);
 }
 
 void GraftImuTopic::setName(const std::string& name){
@@ -62,6 +150,22 @@ void GraftImuTopic::clearMessage(){
 	msg_ = sensor_msgs::Imu::ConstPtr();
 }
 
+bool GraftImuTopic::getDeltaMemory(ros::Time& stamp, geometry_msgs::Pose& pose){
+	if(!delta_orientation_ || last_msg_ == NULL){
+		return false;
+	}
+	stamp = last_msg_->header.stamp;
+	pose.orientation = last_msg_->orientation;
+	return true;
+}
+
+void GraftImuTopic::setDeltaMemory(const ros::Time& stamp, const geometry_msgs::Pose& pose){
+	sensor_msgs::Imu::Ptr msg(new sensor_msgs::Imu());
+	msg->header.stamp = stamp;
+	msg->orientation = pose.orientation;
+	last_msg_ = msg;
+}
+
 geometry_msgs::Twist::Ptr twistFromQuaternions(const geometry_msgs::Quaternion& quat, const geometry_msgs::Quaternion& last_quat, const double dt){
 	geometry_msgs::Twist::Ptr out(new geometry_msgs::Twist());
 	if(dt < 1e-10){
@@ -99,16 +203,21 @@ geometry_msgs::Vector3 accelFromQuaternion(const geometry_msgs::Quaternion& q, c
 	return out;
 }
 
-graft::GraftSensorResidual::Ptr GraftImuTopic::h(const graft::GraftState& state){
-	graft::GraftSensorResidual::Ptr out(new graft::GraftSensorResidual());
-	out->header = state.header;
-	out->name = name_;
-	out->pose = state.pose;
-	out->twist = state.twist;
+void GraftImuTopic::h(const graft::GraftState& state, graft::GraftSensorResidual& out){
+	out.header = state.header;
+	out.name = name_;
+	out.pose = state.pose;
+	out.twist = state.twist;
+	// Gyro reads the body rate plus its bias, zero for filters without bias states
+	out.twist.angular.x += state.gyro_bias.x;
+	out.twist.angular.y += state.gyro_bias.y;
+	out.twist.angular.z += state.gyro_bias.z;
   //ROS_ERROR_STREAM("accelFromQuaternion " << name_ << ", " <<
   //    state.pose.orientation);
-	out->accel = accelFromQuaternion(state.pose.orientation, 9.81);
-  return out;
+	out.accel = accelFromQuaternion(state.pose.orientation, 9.81);
+	out.accel.x += state.acceleration.x + state.accel_bias.x;
+	out.accel.y += state.acceleration.y + state.accel_bias.y;
+	out.accel.z += state.acceleration.z + state.accel_bias.z;
 }
 
 boost::array<double, 36> largeCovarianceFromSmallCovariance(const boost::array<double, 9>& angular_velocity_covariance){
@@ -133,6 +242,9 @@ graft::GraftSensorResidual::Ptr GraftImuTopic::z(){
 		ROS_WARN_THROTTLE(5.0, "%s (IMU) timeout", name_.c_str());
 		return graft::GraftSensorResidual::Ptr();
 	}
+	if(!extrinsics_.resolve(msg_->header.frame_id)){
+		return graft::GraftSensorResidual::Ptr();
+	}
 	graft::GraftSensorResidual::Ptr out(new graft::GraftSensorResidual());
 	out->header = msg_->header;
 	out->name = name_;
@@ -152,6 +264,7 @@ graft::GraftSensorResidual::Ptr GraftImuTopic::z(){
 			out->twist_covariance = largeCovarianceFromSmallCovariance(msg_->orientation_covariance);
 		}
 		out->twist_covariance[35] = msg_->orientation_covariance[8];
+		extrinsics_.transformAngularVelocity(out->twist.angular, out->twist_covariance);
 	} else {
 		out->pose.orientation = msg_->orientation;
 		out->twist.angular = msg_->angular_velocity;
@@ -165,6 +278,8 @@ graft::GraftSensorResidual::Ptr GraftImuTopic::z(){
 		} else { // Use from message
 			out->twist_covariance = largeCovarianceFromSmallCovariance(msg_->angular_velocity_covariance);
 		}
+		extrinsics_.transformOrientation(out->pose.orientation);
+		extrinsics_.transformAngularVelocity(out->twist.angular, out->twist_covariance);
 	}
 
 	
@@ -174,6 +289,7 @@ graft::GraftSensorResidual::Ptr GraftImuTopic::z(){
 	} else { // Use from message
 		out->accel_covariance = msg_->linear_acceleration_covariance;
 	}
+	extrinsics_.transformAcceleration(out->accel, out->twist.angular, out->accel_covariance);
   return out;
 }
 
@@ -201,6 +317,10 @@ void GraftImuTopic::setLinearAccelerationCovariance(boost::array<double, 9>& cov
 	linear_acceleration_covariance_ = cov;
 }
 
+void GraftImuTopic::setExtrinsics(const GraftSensorExtrinsics& extrinsics){
+	extrinsics_ = extrinsics;
+}
+
 sensor_msgs::Imu::ConstPtr GraftImuTopic::getMsg(){
 	return msg_;
 }
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <graft/GraftJointStateTopic.h>
+#include <algorithm>
+
+
+GraftJointStateTopic::GraftJointStateTopic() : wheel_radius_(0.0), track_(0.0), track_multiplier_(1.0),
+                                               wheel_velocity_variance_(0.0), lateral_velocity_variance_(0.0),
+                                               staged_wheel_velocity_variance_(0.0), staged_lateral_velocity_variance_(0.0){
+	useVelocities(true);
+}
+
+GraftJointStateTopic::~GraftJointStateTopic(){
+
+}
+
+bool GraftJointStateTopic::lookupJoints(const sensor_msgs::JointState& msg, const std::vector<std::string>& names, std::vector<size_t>& indices){
+	bool cached = !names.empty() && indices.size() == names.size();
+	for(size_t i = 0; cached && i < indices.size(); i++){
+		cached = indices[i] < msg.name.size() && msg.name[indices[i]] == names[i];
+	}
+	if(cached){
+		return true;
+	}
+	indices.clear();
+	last_msg_.reset(); // Positions of the old order can't be differentiated
+	for(size_t i = 0; i < names.size(); i++){
+		std::vector<std::string>::const_iterator it = std::find(msg.name.begin(), msg.name.end(), names[i]);
+		if(it == msg.name.end()){
+			ROS_WARN_THROTTLE(5.0, "%s (JointState) has no joint %s", getName().c_str(), names[i].c_str());
+			indices.clear();
+			return false;
+		}
+		indices.push_back(it - msg.name.begin());
+	}
+	return !indices.empty();
+}
+
+bool GraftJointStateTopic::sideVelocity(const sensor_msgs::JointState& msg, const std::vector<size_t>& indices, double dt, double& velocity){
+	velocity = 0.0;
+	if(msg.velocity.size() == msg.name.size()){
+		for(size_t i = 0; i < indices.size(); i++){
+			velocity += msg.velocity[indices[i]];
+		}
+	} else if(msg.position.size() == msg.name.size() && last_msg_ != NULL
+			&& last_msg_->position.size() == msg.position.size() && dt > 1e-6){
+		for(size_t i = 0; i < indices.size(); i++){
+			velocity += (msg.position[indices[i]] - last_msg_->position[indices[i]])/dt;
+		}
+	} else {
+		return false;
+	}
+	velocity /= indices.size();
+	return std::isfinite(velocity);
+}
+
+void GraftJointStateTopic::jointStateCallback(const sensor_msgs::JointState::ConstPtr& msg){
+	if(wheel_radius_ < 1e-10 || track_*track_multiplier_ < 1e-10){
+		return;
+	}
+	if(!lookupJoints(*msg, left_wheels_, left_indices_) || !lookupJoints(*msg, right_wheels_, right_indices_)){
+		return;
+	}
+	double dt = 0.0;
+	if(last_msg_ != NULL){
+		dt = (msg->header.stamp - last_msg_->header.stamp).toSec();
+	}
+	double left, right;
+	bool valid = sideVelocity(*msg, left_indices_, dt, left) && sideVelocity(*msg, right_indices_, dt, right);
+	last_msg_ = msg;
+	if(!valid){
+		return;
+	}
+
+	double track = track_*track_multiplier_;
+	nav_msgs::Odometry::Ptr odom(new nav_msgs::Odometry());
+	odom->header = msg->header;
+	odom->child_frame_id = sensor_frame_id_;
+	odom->twist.twist.linear.x = wheel_radius_*(left + right)/2.0;
+	odom->twist.twist.angular.z = wheel_radius_*(right - left)/track;
+
+	// Each side is the mean of its wheels
+	double left_variance = wheel_velocity_variance_/left_indices_.size();
+	double right_variance = wheel_velocity_variance_/right_indices_.size();
+	double r2 = wheel_radius_*wheel_radius_;
+	odom->twist.covariance[0] = r2*(left_variance + right_variance)/4.0;
+	odom->twist.covariance[35] = r2*(left_variance + right_variance)/(track*track);
+	odom->twist.covariance[5] = r2*(right_variance - left_variance)/(2.0*track);
+	odom->twist.covariance[30] = odom->twist.covariance[5];
+	odom->twist.covariance[7] = lateral_velocity_variance_; // No side slip, vy = 0
+	callback(odom);
+}
+
+void GraftJointStateTopic::configure(ros::NodeHandle& tnh){
+	GraftOdometryTopic::configure(tnh);
+	useAbsolutePose(false);
+	useDeltaPose(false);
+	useVelocities(true);
+	tnh.param<std::string>("sensor_frame_id", sensor_frame_id_, "");
+	tnh.getParam("left_wheels", left_wheels_);
+	tnh.getParam("right_wheels", right_wheels_);
+	left_indices_.clear();
+	right_indices_.clear();
+	tnh.param<double>("wheel_radius", wheel_radius_, 0.0);
+	tnh.param<double>("track", track_, 0.0);
+	tnh.param<double>("track_multiplier", track_multiplier_, 1.0);
+
+	if(left_wheels_.empty() || right_wheels_.empty()){
+		ROS_ERROR("%s requires left_wheels and right_wheels.", tnh.getNamespace().c_str());
+	}
+	if(wheel_radius_ < 1e-10 || track_*track_multiplier_ < 1e-10){
+		ROS_ERROR("%s requires a positive wheel_radius and track.", tnh.getNamespace().c_str());
+	}
+}
+
+void GraftJointStateTopic::stageTuning(ros::NodeHandle& tnh){
+	GraftOdometryTopic::stageTuning(tnh);
+	tnh.param<double>("wheel_velocity_variance", staged_wheel_velocity_variance_, 0.0);
+	tnh.param<double>("lateral_velocity_variance", staged_lateral_velocity_variance_, 0.0);
+}
+
+void GraftJointStateTopic::commitTuning(){
+	GraftOdometryTopic::commitTuning();
+	wheel_velocity_variance_ = staged_wheel_velocity_variance_;
+	lateral_velocity_variance_ = staged_lateral_velocity_variance_;
+}
+
+ros::Subscriber GraftJointStateTopic::subscribe(ros::NodeHandle& n, const std::string& topic, const uint32_t queue_size){
+	return n.subscribe(topic, queue_size, &GraftJointStateTopic::jointStateCallback, this);
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <graft/GraftNavSatFixTopic.h>
+
+// WGS84 ellipsoid
+static const double WGS84_A = 6378137.0;
+static const double WGS84_F = 1.0/298.257223563;
+static const double WGS84_E2 = WGS84_F*(2.0 - WGS84_F);
+
+
+GraftNavSatFixTopic::GraftNavSatFixTopic() : has_datum_(false), datum_altitude_(0.0), unknown_variance_(0.0), fix_inflation_(1.0),
+                                             staged_unknown_variance_(0.0), staged_fix_inflation_(1.0),
+                                             warned_unknown_variance_(false){
+	useAbsolutePose(true);
+	datum_ecef_.setZero();
+	ecef_to_enu_.setIdentity();
+}
+
+GraftNavSatFixTopic::~GraftNavSatFixTopic(){
+
+}
+
+Vector3d GraftNavSatFixTopic::toECEF(double latitude, double longitude, double altitude){
+	double lat = latitude*M_PI/180.0;
+	double lon = longitude*M_PI/180.0;
+	double slat = std::sin(lat);
+	double clat = std::cos(lat);
+	double n = WGS84_A/std::sqrt(1.0 - WGS84_E2*slat*slat);
+	return Vector3d((n + altitude)*clat*std::cos(lon),
+	                (n + altitude)*clat*std::sin(lon),
+	                (n*(1.0 - WGS84_E2) + altitude)*slat);
+}
+
+void GraftNavSatFixTopic::setDatum(double latitude, double longitude, double altitude){
+	double lat = latitude*M_PI/180.0;
+	double lon = longitude*M_PI/180.0;
+	double slat = std::sin(lat);
+	double clat = std::cos(lat);
+	double slon = std::sin(lon);
+	double clon = std::cos(lon);
+	ecef_to_enu_ << -slon, clon, 0.0,
+	                -slat*clon, -slat*slon, clat,
+	                clat*clon, clat*slon, slat;
+	datum_ecef_ = toECEF(latitude, longitude, altitude);
+	datum_altitude_ = altitude;
+	has_datum_ = true;
+	ROS_INFO("%s datum at %.8f, %.8f, %.3f", getName().c_str(), latitude, longitude, altitude);
+}
+
+void GraftNavSatFixTopic::navSatFixCallback(const sensor_msgs::NavSatFix::ConstPtr& msg){
+	if(msg->status.status == sensor_msgs::NavSatStatus::STATUS_NO_FIX
+			|| !std::isfinite(msg->latitude) || !std::isfinite(msg->longitude)){
+		ROS_WARN_THROTTLE(5.0, "%s (NavSatFix) has no fix", getName().c_str());
+		return;
+	}
+	// 2D fixes have no altitude, hold the datum altitude and leave it unmeasured
+	bool has_altitude = std::isfinite(msg->altitude);
+	if(!has_datum_){
+		setDatum(msg->latitude, msg->longitude, has_altitude ? msg->altitude : 0.0);
+	}
+	double altitude = has_altitude ? msg->altitude : datum_altitude_;
+	Vector3d enu = ecef_to_enu_*(toECEF(msg->latitude, msg->longitude, altitude) - datum_ecef_);
+
+	nav_msgs::Odometry::Ptr odom(new nav_msgs::Odometry());
+	odom->header = msg->header;
+	odom->child_frame_id = sensor_frame_id_;
+	odom->pose.pose.position.x = enu(0);
+	odom->pose.pose.position.y = enu(1);
+	odom->pose.pose.position.z = enu(2);
+	odom->pose.pose.orientation.w = 1.0;
+
+	// ENU position covariance into the position block, orientation is left unmeasured
+	double scale = 1.0;
+	if(msg->status.status == sensor_msgs::NavSatStatus::STATUS_FIX){
+		scale = fix_inflation_;
+	}
+	int axes = has_altitude ? 3 : 2;
+	if(msg->position_covariance_type == sensor_msgs::NavSatFix::COVARIANCE_TYPE_UNKNOWN && unknown_variance_ <= 0.0 && !warned_unknown_variance_){
+		ROS_WARN("%s (NavSatFix) reports no covariance and unknown_variance is not set, its fixes are not fused.", getName().c_str());
+		warned_unknown_variance_ = true;
+	}
+	for(int i = 0; i < axes; i++){
+		switch(msg->position_covariance_type){
+			case sensor_msgs::NavSatFix::COVARIANCE_TYPE_UNKNOWN:
+				odom->pose.covariance[i*6 + i] = unknown_variance_;
+				break;
+			case sensor_msgs::NavSatFix::COVARIANCE_TYPE_DIAGONAL_KNOWN:
+				odom->pose.covariance[i*6 + i] = scale*msg->position_covariance[i*3 + i];
+				break;
+			default: // Approximated or known
+				for(int j = 0; j < axes; j++){
+					odom->pose.covariance[i*6 + j] = scale*msg->position_covariance[i*3 + j];
+				}
+				break;
+		}
+	}
+	callback(odom);
+}
+
+void GraftNavSatFixTopic::configure(ros::NodeHandle& tnh){
+	GraftOdometryTopic::configure(tnh);
+	useAbsolutePose(true);
+	useDeltaPose(false);
+	useVelocities(false); // No twist in the message
+	tnh.param<std::string>("sensor_frame_id", sensor_frame_id_, "");
+
+	XmlRpc::XmlRpcValue xml_datum;
+	if(tnh.getParam("datum", xml_datum)){
+		if(xml_datum.size() == 3){
+			double datum[3];
+			for(size_t i = 0; i < xml_datum.size(); i++){
+				std::stringstream ss; // Convert the list element into doubles
+				ss << xml_datum[i];
+				ss >> datum[i] ? datum[i] : 0;
+			}
+			setDatum(datum[0], datum[1], datum[2]);
+		} else {
+			ROS_WARN("%s/datum parameter requires 3 elements, using the first fix.", tnh.getNamespace().c_str());
+		}
+	}
+}
+
+void GraftNavSatFixTopic::stageTuning(ros::NodeHandle& tnh){
+	GraftOdometryTopic::stageTuning(tnh);
+	tnh.param<double>("unknown_variance", staged_unknown_variance_, 0.0);
+	tnh.param<double>("fix_inflation", staged_fix_inflation_, 1.0);
+}
+
+void GraftNavSatFixTopic::commitTuning(){
+	GraftOdometryTopic::commitTuning();
+	unknown_variance_ = staged_unknown_variance_;
+	fix_inflation_ = staged_fix_inflation_;
+	warned_unknown_variance_ = false;
+}
+
+ros::Subscriber GraftNavSatFixTopic::subscribe(ros::NodeHandle& n, const std::string& topic, const uint32_t queue_size){
+	return n.subscribe(topic, queue_size, &GraftNavSatFixTopic::navSatFixCallback, this);
+}
@@ -35,8 +35,12 @@
 
 
 GraftOdometryTopic::GraftOdometryTopic(): absolute_pose_(false), delta_pose_(false),
-                                          use_velocities_(false), timeout_(1.0){
-
+                                          use_velocities_(false), timeout_(1.0), sensor_position_(false),
+                                          staged_timeout_(1.0){
+	for( int i=0; i<36; i++ ) {
+		pose_covariance_[i] = 0.0; // Read from message until overridden
+		twist_covariance_[i] = 0.0;
+	}
 }
 
 GraftOdometryTopic::~GraftOdometryTopic(){
@@ -45,6 +49,76 @@ GraftOdometryTopic::~GraftOdometryTopic(){
 
 void GraftOdometryTopic::callback(const nav_msgs::Odometry::ConstPtr& msg){
 	msg_ = msg;
+	notifyArrival();
+}
+
+void GraftOdometryTopic::configure(ros::NodeHandle& tnh){
+	// Check how to use this sensor
+	bool absolute_pose, delta_pose, use_velocities;
+	tnh.param<bool>("absolute_pose", absolute_pose, false);
+	tnh.param<bool>("delta_pose", delta_pose, false);
+	tnh.param<bool>("use_velocities", use_velocities, false);
+
+	// Check for incompatible usage
+	if(absolute_pose == true){
+		delta_pose = false; // Should not use for both absolute position and velocity
+	}
+	if(delta_pose == true){
+		use_velocities = false; // Should not use both estimated and reported velocities
+	}
+
+	// Apply to sensor
+	useAbsolutePose(absolute_pose);
+	useDeltaPose(delta_pose);
+	useVelocities(use_velocities);
+  configureTuning(tnh);
+
+  //ROS_INFO("Abs pose: %d\nDelta pose: %d\nUse Vel: %d\nTimeout: %.3f", absolute_pose, delta_pose, use_velocities, timeout_.toSec());
+}
+
+void GraftOdometryTopic::stageTuning(ros::NodeHandle& tnh){
+  tnh.param<double>("timeout", staged_timeout_, 1.0);
+
+  // Set covariances, all zero reads them from the message
+  boost::array<double, 36>& pose_covariance = staged_pose_covariance_;
+  pose_covariance.assign(0.0);
+  XmlRpc::XmlRpcValue xml_pose_covariance;
+  if (tnh.getParam("override_pose_covariance", xml_pose_covariance)){
+  	if(xml_pose_covariance.size() == 36){
+	    for(size_t i = 0; i < xml_pose_covariance.size(); i++){
+	      std::stringstream ss; // Convert the list element into doubles
+	      ss << xml_pose_covariance[i];
+	      ss >> pose_covariance[i] ? pose_covariance[i] : 0;
+	    }
+    } else {
+    	ROS_WARN("%s/override_pose_covariance parameter requires 36 elements, skipping.", tnh.getNamespace().c_str());
+    }
+  }
+
+  boost::array<double, 36>& twist_covariance = staged_twist_covariance_;
+  twist_covariance.assign(0.0);
+  XmlRpc::XmlRpcValue xml_twist_covariance;
+  if (tnh.getParam("override_twist_covariance", xml_twist_covariance)){
+  	if(xml_twist_covariance.size() == 36){
+	    for(size_t i = 0; i < xml_twist_covariance.size(); i++){
+	      std::stringstream ss; // Convert the list element into doubles
+	      ss << xml_twist_covariance[i];
+	      ss >> twist_covariance[i] ? twist_covariance[i] : 0;
+	    }
+    } else {
+    	ROS_WARN("%s/override_twist_covariance parameter requires 36 elements, skipping.", tnh.getNamespace().c_str());
+    }
+  }
+}
+
+void GraftOdometryTopic::commitTuning(){
+  setTimeout(staged_timeout_);
+  setPoseCovariance(staged_pose_covariance_);
+  setTwistCovariance(staged_twist_covariance_);
+}
+
+ros::Subscriber GraftOdometryTopic::subscribe(ros::NodeHandle& n, const std::string& topic, const uint32_t queue_size){
+	return n.subscribe(topic, queue_size, &GraftOdometryTopic::callback, this);
 }
 
 void GraftOdometryTopic::setName(const std::string& name){
@@ -59,6 +133,22 @@ void GraftOdometryTopic::clearMessage(){
 	msg_ = nav_msgs::Odometry::ConstPtr();
 }
 
+bool GraftOdometryTopic::getDeltaMemory(ros::Time& stamp, geometry_msgs::Pose& pose){
+	if(!delta_pose_ || last_msg_ == NULL){
+		return false;
+	}
+	stamp = last_msg_->header.stamp;
+	pose = last_msg_->pose.pose;
+	return true;
+}
+
+void GraftOdometryTopic::setDeltaMemory(const ros::Time& stamp, const geometry_msgs::Pose& pose){
+	nav_msgs::Odometry::Ptr msg(new nav_msgs::Odometry());
+	msg->header.stamp = stamp;
+	msg->pose.pose = pose;
+	last_msg_ = msg;
+}
+
 geometry_msgs::Twist::Ptr twistFromPoses(const geometry_msgs::Pose& pose, const geometry_msgs::Pose& last_pose, const double dt){
 	geometry_msgs::Twist::Ptr out(new geometry_msgs::Twist());
 	if(dt < 1e-10){
@@ -85,13 +175,14 @@ geometry_msgs::Twist::Ptr twistFromPoses(const geometry_msgs::Pose& pose, const
 }
 
 
-graft::GraftSensorResidual::Ptr GraftOdometryTopic::h(const graft::GraftState& state){
-	graft::GraftSensorResidual::Ptr out(new graft::GraftSensorResidual());
-	out->header = state.header;
-	out->name = name_;
-	out->pose = state.pose;
-	out->twist = state.twist;
-  return out;
+void GraftOdometryTopic::h(const graft::GraftState& state, graft::GraftSensorResidual& out){
+	out.header = state.header;
+	out.name = name_;
+	out.pose = state.pose;
+	out.twist = state.twist;
+	if(sensor_position_){
+		extrinsics_.sensorPosition(out.pose); // Lever arm along the estimated orientation
+	}
 }
 
 graft::GraftSensorResidual::Ptr GraftOdometryTopic::z(){
@@ -99,6 +190,9 @@ graft::GraftSensorResidual::Ptr GraftOdometryTopic::z(){
 		ROS_WARN_THROTTLE(5.0, "%s (Odometry) timeout", name_.c_str());
 		return graft::GraftSensorResidual::Ptr();
 	}
+	if(!extrinsics_.resolve(msg_->child_frame_id)){
+		return graft::GraftSensorResidual::Ptr();
+	}
 	graft::GraftSensorResidual::Ptr out(new graft::GraftSensorResidual());
 	out->header = msg_->header;
 	out->name = name_;
@@ -125,6 +219,7 @@ graft::GraftSensorResidual::Ptr GraftOdometryTopic::z(){
 			out->twist_covariance = msg_->twist.covariance;
 		}
 	}
+	extrinsics_.transformTwist(out->twist, out->twist_covariance);
 
 	if(absolute_pose_ && !delta_pose_){ // Delta Pose and Absolute Pose are incompatible
 		out->pose = msg_->pose.pose;
@@ -133,7 +228,9 @@ graft::GraftSensorResidual::Ptr GraftOdometryTopic::z(){
 		} else { // Use from message
 			out->pose_covariance = msg_->pose.covariance;
 		}
+		extrinsics_.transformPose(out->pose, out->pose_covariance);
 	}
+	sensor_position_ = absolute_pose_ && !delta_pose_ && GraftSensorExtrinsics::isPositionOnly(out->pose, out->pose_covariance);
   return out;
 }
 
@@ -153,6 +250,10 @@ void GraftOdometryTopic::setTwistCovariance(boost::array<double, 36>& cov){
 	twist_covariance_ = cov;
 }
 
+void GraftOdometryTopic::setExtrinsics(const GraftSensorExtrinsics& extrinsics){
+	extrinsics_ = extrinsics;
+}
+
 void GraftOdometryTopic::useAbsolutePose(bool absolute_pose){
 	absolute_pose_ = absolute_pose;
 }
@@ -36,8 +36,8 @@
 
 
 
-GraftParameterManager::GraftParameterManager(ros::NodeHandle n, ros::NodeHandle pnh): n_(n), pnh_(pnh),
-                                                                                      include_pose_(false){
+GraftParameterManager::GraftParameterManager(ros::NodeHandle n, ros::NodeHandle pnh): n_(n), pnh_(pnh), realtime_(false),
+                                                                                      realtime_queue_(NULL), include_pose_(false){
 
 }
 
@@ -45,146 +45,104 @@ GraftParameterManager::~GraftParameterManager(){
 
 }
 
-void GraftParameterManager::parseNavMsgsOdometryParameters(ros::NodeHandle& tnh, boost::shared_ptr<GraftOdometryTopic>& odom){
-	// Check how to use this sensor
-	bool absolute_pose, delta_pose, use_velocities;
-	double timeout;
-	tnh.param<bool>("absolute_pose", absolute_pose, false);
-	tnh.param<bool>("delta_pose", delta_pose, false);
-	tnh.param<bool>("use_velocities", use_velocities, false);
-	tnh.param<double>("timeout", timeout, 1.0);
-
-	// Check for incompatible usage
-	if(absolute_pose == true){
-		delta_pose = false; // Should not use for both absolute position and velocity
+GraftSensorExtrinsics GraftParameterManager::parseExtrinsics(ros::NodeHandle& tnh){
+	// Sensor frame -> child_frame_id, from parameters or looked up once from tf
+	GraftSensorExtrinsics extrinsics;
+	XmlRpc::XmlRpcValue xml_extrinsics;
+	if(tnh.getParam("extrinsics", xml_extrinsics)){
+		if(xml_extrinsics.size() == 6){
+			std::vector<double> xyzrpy(6);
+			for(size_t i = 0; i < xml_extrinsics.size(); i++){
+				std::stringstream ss; // Convert the list element into doubles
+				ss << xml_extrinsics[i];
+				ss >> xyzrpy[i] ? xyzrpy[i] : 0;
+			}
+			extrinsics.setTransform(xyzrpy);
+			return extrinsics;
+		} else {
+			ROS_WARN("%s/extrinsics parameter requires 6 elements, skipping.", tnh.getNamespace().c_str());
+		}
 	}
-	if(delta_pose == true){
-		use_velocities = false; // Should not use both estimated and reported velocities
+
+	bool lookup_extrinsics;
+	tnh.param<bool>("lookup_extrinsics", lookup_extrinsics, false);
+	if(lookup_extrinsics){
+		if(tf_listener_ == NULL){
+			tf_listener_.reset(new tf::TransformListener());
+		}
+		extrinsics.setTransformListener(tf_listener_, child_frame_id_);
 	}
+	return extrinsics;
+}
+
+void GraftParameterManager::configureTopic(ros::NodeHandle& tnh, boost::shared_ptr<GraftSensor> topic){
+	topic->configure(tnh);
+	topic->setExtrinsics(parseExtrinsics(tnh));
+	parseGate(tnh, topic);
 
 	// Apply to global state
-	include_pose_ = include_pose_ || absolute_pose;
-
-	// Apply to sensor
-	odom->useAbsolutePose(absolute_pose);
-	odom->useDeltaPose(delta_pose);
-	odom->useVelocities(use_velocities);
-  odom->setTimeout(timeout);
-
-  //ROS_INFO("Abs pose: %d\nDelta pose: %d\nUse Vel: %d\nTimeout: %.3f", absolute_pose, delta_pose, use_velocities, timeout);
-
-  // Set covariances
-  XmlRpc::XmlRpcValue xml_pose_covariance;
-  if (tnh.getParam("override_pose_covariance", xml_pose_covariance)){
-  	if(xml_pose_covariance.size() == 36){
-  		boost::array<double, 36> pose_covariance;
-	    for(size_t i = 0; i < xml_pose_covariance.size(); i++){
-	      std::stringstream ss; // Convert the list element into doubles
-	      ss << xml_pose_covariance[i];
-	      ss >> pose_covariance[i] ? pose_covariance[i] : 0;
-	    }
-	    odom->setPoseCovariance(pose_covariance);
-    } else {
-    	ROS_WARN("%s/override_pose_covariance parameter requires 36 elements, skipping.", tnh.getNamespace().c_str());
-    }
-  }
+	bool absolute_pose, absolute_orientation;
+	tnh.param<bool>("absolute_pose", absolute_pose, false);
+	tnh.param<bool>("absolute_orientation", absolute_orientation, false);
+	include_pose_ = include_pose_ || absolute_pose || absolute_orientation;
+}
 
-  XmlRpc::XmlRpcValue xml_twist_covariance;
-  if (tnh.getParam("override_twist_covariance", xml_twist_covariance)){
-  	if(xml_twist_covariance.size() == 36){
-  		boost::array<double, 36> twist_covariance;
-	    for(size_t i = 0; i < xml_twist_covariance.size(); i++){
-	      std::stringstream ss; // Convert the list element into doubles
-	      ss << xml_twist_covariance[i];
-	      ss >> twist_covariance[i] ? twist_covariance[i] : 0;
-	    }
-	    odom->setTwistCovariance(twist_covariance);
-    } else {
-    	ROS_WARN("%s/override_twist_covariance parameter requires 36 elements, skipping.", tnh.getNamespace().c_str());
-    }
-  }
+void GraftParameterManager::parseGate(ros::NodeHandle& tnh, boost::shared_ptr<GraftSensor> topic){
+	topic->getGate().setProbability(parseGateProbability(tnh));
 }
 
-void GraftParameterManager::parseSensorMsgsIMUParameters(ros::NodeHandle& tnh, boost::shared_ptr<GraftImuTopic>& imu){
-	// Check how to use this sensor
-	bool absolute_orientation, delta_orientation, use_velocities, use_accelerations;
-	double timeout;
-	tnh.param<bool>("absolute_orientation", absolute_orientation, false);
-	tnh.param<bool>("delta_orientation", delta_orientation, false);
-	tnh.param<bool>("use_velocities", use_velocities, false);
-	tnh.param<bool>("use_accelerations", use_accelerations, false);
-	tnh.param<double>("timeout", timeout, 1.0);
-
-	// Check for incompatible usage
-	if(absolute_orientation == true){
-		delta_orientation = false; // Should not use for both absolute position and velocity
-	}
-	if(delta_orientation == true){
-		use_velocities = false; // Should not use both estimated and reported velocities
+double GraftParameterManager::parseGateProbability(ros::NodeHandle& tnh){
+	double probability;
+	tnh.param<double>("gate_probability", probability, 0.0);
+	if(probability >= 1.0 || probability < 0.0){
+		ROS_WARN("%s/gate_probability (%.3f) must be in [0, 1), not gating.", tnh.getNamespace().c_str(), probability);
+		probability = 0.0;
 	}
+	return probability;
+}
 
-	// Apply to global state
-	include_pose_ = include_pose_ || absolute_orientation;
-
-	// Apply to sensor
-	//imu->useAbsoluteOrientation(absolute_orientation);
-	imu->useDeltaOrientation(delta_orientation);
-	//imu->useVelocities(use_velocities);
-	//imu->useAccelerations(use_accelerations);
-  imu->setTimeout(timeout);
-
-  ROS_INFO("Abs orientation: %d\nDelta orientation: %d\nUse Vel: %d\nTimeout: %.3f", absolute_orientation, delta_orientation, use_velocities, timeout);
-
-  // Set covariances
-  XmlRpc::XmlRpcValue xml_orientation_covariance;
-  if (tnh.getParam("override_orientation_covariance", xml_orientation_covariance)){
-  	if(xml_orientation_covariance.size() == 9){
-  		boost::array<double, 9> orientation_covariance;
-	    for(size_t i = 0; i < xml_orientation_covariance.size(); i++){
-	      std::stringstream ss; // Convert the list element into doubles
-	      ss << xml_orientation_covariance[i];
-	      ss >> orientation_covariance[i] ? orientation_covariance[i] : 0;
-	    }
-	    imu->setOrientationCovariance(orientation_covariance);
-    } else {
-    	ROS_WARN("%s/override_orientation_covariance parameter requires 9 elements, skipping.", tnh.getNamespace().c_str());
-    }
-  }
+void GraftParameterManager::addToUpdateGroup(ros::NodeHandle& tnh, boost::shared_ptr<GraftSensor> topic){
+	// Topics without a group are fused together at update_rate
+	std::string group_name;
+	double rate;
+	int priority;
+	tnh.param<std::string>("update_group", group_name, "default");
+	tnh.param<double>("rate", rate, update_rate_);
+	tnh.param<int>("priority", priority, 0);
+	if(rate < 0.0){
+		rate = 0.0; // Fuse on arrival
+	}
 
-  XmlRpc::XmlRpcValue xml_angular_velocity_covariance;
-  if (tnh.getParam("override_angular_velocity_covariance", xml_angular_velocity_covariance)){
-  	if(xml_angular_velocity_covariance.size() == 9){
-  		boost::array<double, 9> angular_velocity_covariance;
-	    for(size_t i = 0; i < xml_angular_velocity_covariance.size(); i++){
-	      std::stringstream ss; // Convert the list element into doubles
-	      ss << xml_angular_velocity_covariance[i];
-	      ss >> angular_velocity_covariance[i] ? angular_velocity_covariance[i] : 0;
-	    }
-	    imu->setAngularVelocityCovariance(angular_velocity_covariance);
-    } else {
-    	ROS_WARN("%s/override_angular_velocity_covariance parameter requires 9 elements, skipping.", tnh.getNamespace().c_str());
-    }
-  }
+	for(size_t i = 0; i < update_groups_.size(); i++){
+		if(update_groups_[i].name != group_name){
+			continue;
+		}
+		if(std::abs(update_groups_[i].rate - rate) > 1e-9){
+			// Keep the faster of the two, fusing on arrival is fastest
+			double group_rate = update_groups_[i].rate;
+			if(group_rate > 1e-10 && (rate < 1e-10 || rate > group_rate)){
+				group_rate = rate;
+			}
+			ROS_WARN("%s/rate (%.3f) does not match the rest of update group '%s', using %.3f.", tnh.getNamespace().c_str(), rate, group_name.c_str(), group_rate);
+			update_groups_[i].rate = group_rate;
+		}
+		update_groups_[i].priority = std::max(update_groups_[i].priority, priority);
+		update_groups_[i].topics.push_back(topic);
+		return;
+	}
 
-  XmlRpc::XmlRpcValue xml_linear_acceleration_covariance;
-  if (tnh.getParam("override_linear_acceleration_covariance", xml_linear_acceleration_covariance)){
-  	if(xml_linear_acceleration_covariance.size() == 9){
-  		boost::array<double, 9> linear_acceleration_covariance;
-	    for(size_t i = 0; i < xml_linear_acceleration_covariance.size(); i++){
-	      std::stringstream ss; // Convert the list element into doubles
-	      ss << xml_linear_acceleration_covariance[i];
-	      ss >> linear_acceleration_covariance[i] ? linear_acceleration_covariance[i] : 0;
-	    }
-	    imu->setLinearAccelerationCovariance(linear_acceleration_covariance);
-    } else {
-    	ROS_WARN("%s/override_linear_acceleration_covariance parameter requires 9 elements, skipping.", tnh.getNamespace().c_str());
-    }
-  }
+	GraftUpdateGroup group;
+	group.name = group_name;
+	group.rate = rate;
+	group.priority = priority;
+	group.topics.push_back(topic);
+	update_groups_.push_back(group);
 }
 
 void GraftParameterManager::loadParameters(std::vector<boost::shared_ptr<GraftSensor> >& topics, std::vector<ros::Subscriber>& subs){
 	// Filter behavior parameters
 	pnh_.param<std::string>("filter_type", filter_type_, "EKF");
+	pnh_.param<std::string>("process_model", process_model_, "velocity");
 	pnh_.param<bool>("planar_output", planar_output_, true);
 
 	pnh_.param<std::string>("parent_frame_id", parent_frame_id_, "odom");
@@ -192,9 +150,30 @@ void GraftParameterManager::loadParameters(std::vector<boost::shared_ptr<GraftSe
 
 	pnh_.param<double>("freq", update_rate_, 50.0);
 	pnh_.param<double>("update_rate", update_rate_, update_rate_); // Overrides 'freq'
+	pnh_.param<double>("output_rate", output_rate_, 0.0);
 	pnh_.param<double>("dt_override", dt_override_, 0.0);
 
   pnh_.param<bool>("publish_tf", publish_tf_, false);
+  pnh_.param<std::string>("shared_memory_name", shared_memory_name_, "");
+  pnh_.param<int>("state_history", state_history_size_, 100);
+  pnh_.param<int>("smoother_lag", smoother_lag_, 0);
+  pnh_.param<bool>("initialize_from_measurements", initialize_from_measurements_, false);
+  pnh_.param<double>("initialization_timeout", initialization_timeout_, 10.0);
+  pnh_.param<double>("recovery_inflation", recovery_inflation_, 10.0);
+  pnh_.param<int>("max_recoveries", max_recoveries_, 3);
+  pnh_.param<double>("update_deadline", update_deadline_, 0.0);
+  pnh_.param<bool>("realtime", realtime_, false);
+  pnh_.param<int>("realtime_priority", realtime_priority_, 0);
+  pnh_.param<int>("realtime_cpu", realtime_cpu_, -1);
+  pnh_.param<bool>("realtime_lock_memory", realtime_lock_memory_, true);
+  if(realtime_ && realtime_queue_ == NULL){
+    realtime_ = false;
+  }
+  pnh_.param<std::string>("checkpoint_file", checkpoint_file_, "");
+  pnh_.param<double>("checkpoint_rate", checkpoint_rate_, 1.0);
+  pnh_.param<double>("checkpoint_max_age", checkpoint_max_age_, 30.0);
+  pnh_.param<std::string>("flight_recorder_file", flight_recorder_file_, "");
+  pnh_.param<int>("flight_recorder_size", flight_recorder_size_, 64);
 
 	pnh_.param<int>("queue_size", queue_size_, 1);
 
@@ -214,15 +193,21 @@ void GraftParameterManager::loadParameters(std::vector<boost::shared_ptr<GraftSe
   }
 
 	// Process noise covariance
-	XmlRpc::XmlRpcValue xml_process_noise;
-  if (pnh_.getParam("process_noise", xml_process_noise)){
-    process_noise_.resize(xml_process_noise.size());
-    for(size_t i = 0; i < xml_process_noise.size(); i++){
-      std::stringstream ss; // Convert the list element into doubles
-      ss << xml_process_noise[i];
-      ss >> process_noise_[i] ? process_noise_[i] : 0;
-    }
-  }
+	parseProcessNoise(process_noise_);
+
+	// Interacting multiple model
+	pnh_.param<double>("imm_stay_probability", imm_stay_probability_, 0.95);
+	pnh_.param<bool>("imm_threads", imm_threads_, true);
+	if(imm_stay_probability_ <= 0.0 || imm_stay_probability_ > 1.0){
+		ROS_WARN("imm_stay_probability (%.3f) must be in (0, 1], using 0.95.", imm_stay_probability_);
+		imm_stay_probability_ = 0.95;
+	}
+	try{
+		parseIMMModes(imm_modes_);
+	} catch(...){
+		ROS_ERROR("XmlRpc error parsing imm_modes, running a single filter.");
+		imm_modes_.clear();
+	}
 
 	// Read each topic config
 	try{
@@ -236,13 +221,29 @@ void GraftParameterManager::loadParameters(std::vector<boost::shared_ptr<GraftSe
 
     // Iterate over the map of each joint and its parameters
     std::map<std::string, XmlRpc::XmlRpcValue>::iterator i;
+
+    // Cascade inputs are handed over from another thread, which the real-time loop can't share
+    for (i = topic_list.begin(); realtime_ && i != topic_list.end(); i++){
+      ros::NodeHandle tnh(pnh_, "topics/" + i->first);
+      bool cascade_input;
+      tnh.param<bool>("cascade_input", cascade_input, false);
+      if(cascade_input){
+        ROS_WARN("%s/cascade_input can not be combined with realtime, running on the callback queue.", tnh.getNamespace().c_str());
+        realtime_ = false;
+      }
+    }
+    ros::NodeHandle topic_n(n_);
+    if(realtime_){
+      topic_n.setCallbackQueue(realtime_queue_);
+    }
+
     for (i = topic_list.begin(); i != topic_list.end(); i++)
     {
     	// Get the name of this topic.  ex: base_odometry
       std::string topic_name = i->first;
 
       // Set up a nodehandle in this namespace (so we don't have to deal with the XmlRpc object)
-      ros::NodeHandle tnh("~/topics/" + topic_name);
+      ros::NodeHandle tnh(pnh_, "topics/" + topic_name);
 
       ROS_INFO("Topic name: %s", topic_name.c_str());
 
@@ -255,45 +256,36 @@ void GraftParameterManager::loadParameters(std::vector<boost::shared_ptr<GraftSe
 
       ROS_INFO("Type: %s", type.c_str());
 
-      if(type == "nav_msgs/Odometry"){
-      	std::string full_topic;
-      	if(!tnh.getParam("topic", full_topic)){
-      		ROS_ERROR("Could not get full topic for %s, skipping.", topic_name.c_str());
-      		continue;
-      	}
-
-      	// Create Odometry object
-      	boost::shared_ptr<GraftOdometryTopic> odom(new GraftOdometryTopic());
-        odom->setName(topic_name);
-      	topics.push_back(odom);	
-
-      	// Subscribe to topic
-      	ros::Subscriber sub = n_.subscribe(full_topic, queue_size_, &GraftOdometryTopic::callback, odom);
-      	subs.push_back(sub);
-
-      	// Parse rest of parameters
-      	parseNavMsgsOdometryParameters(tnh, odom);
-      } else if(type == "sensor_msgs/Imu"){
-      	std::string full_topic;
-      	if(!tnh.getParam("topic", full_topic)){
-      		ROS_ERROR("Could not get full topic for %s, skipping.", topic_name.c_str());
-      		continue;
-      	}
-
-      	// Create Odometry object
-      	boost::shared_ptr<GraftImuTopic> imu(new GraftImuTopic());
-        imu->setName(topic_name);
-      	topics.push_back(imu);	
-
-      	// Subscribe to topic
-      	ros::Subscriber sub = n_.subscribe(full_topic, queue_size_, &GraftImuTopic::callback, imu);
-      	subs.push_back(sub);
-
-      	// Parse rest of parameters
-      	parseSensorMsgsIMUParameters(tnh, imu);
-      } else {
+      boost::shared_ptr<GraftSensor> topic = registry_.create(type);
+      if(topic == NULL){
       	ROS_WARN("Unknown type: %s  Not parsing configuration.", type.c_str());
+      	continue;
+      }
+
+      // Odometry can be fed by the previous stage of graft_ukf_cascade instead of subscribed
+      bool cascade_input;
+      tnh.param<bool>("cascade_input", cascade_input, false);
+      boost::shared_ptr<GraftOdometryTopic> odom = boost::dynamic_pointer_cast<GraftOdometryTopic>(topic);
+      cascade_input = cascade_input && odom != NULL;
+
+      std::string full_topic;
+      if(!cascade_input && !tnh.getParam("topic", full_topic)){
+      	ROS_ERROR("Could not get full topic for %s, skipping.", topic_name.c_str());
+      	continue;
+      }
+
+      topic->setName(topic_name);
+      topics.push_back(topic);
+
+      if(cascade_input){
+      	cascade_inputs_.push_back(odom);
+      } else { // Subscribe to topic
+      	subs.push_back(topic->subscribe(topic_n, full_topic, queue_size_));
       }
+
+      // Parse rest of parameters
+      configureTopic(tnh, topic);
+      addToUpdateGroup(tnh, topic);
     }
 
 	} catch(...){
@@ -304,10 +296,141 @@ void GraftParameterManager::loadParameters(std::vector<boost::shared_ptr<GraftSe
 }
 
 
+void GraftParameterManager::parseProcessNoise(std::vector<double>& process_noise){
+	XmlRpc::XmlRpcValue xml_process_noise;
+  if (pnh_.getParam("process_noise", xml_process_noise)){
+    process_noise.resize(xml_process_noise.size());
+    for(size_t i = 0; i < xml_process_noise.size(); i++){
+      std::stringstream ss; // Convert the list element into doubles
+      ss << xml_process_noise[i];
+      ss >> process_noise[i] ? process_noise[i] : 0;
+    }
+  }
+}
+
+void GraftParameterManager::parseIMMModes(std::vector<GraftIMMMode>& modes){
+	modes.clear();
+	XmlRpc::XmlRpcValue xml_modes;
+	if(!pnh_.getParam("imm_modes", xml_modes)){
+		return;
+	}
+	std::map<std::string, XmlRpc::XmlRpcValue>::iterator i;
+	for(i = xml_modes.begin(); i != xml_modes.end(); i++){
+		ros::NodeHandle mnh(pnh_, "imm_modes/" + i->first);
+		GraftIMMMode mode;
+		mode.name = i->first;
+		mnh.param<double>("probability", mode.probability, 1.0);
+		XmlRpc::XmlRpcValue xml_process_noise;
+		if(!mnh.getParam("process_noise", xml_process_noise)){
+			ROS_ERROR("%s/process_noise is not set, skipping mode.", mnh.getNamespace().c_str());
+			continue;
+		}
+		mode.process_noise.resize(xml_process_noise.size());
+		for(size_t j = 0; j < xml_process_noise.size(); j++){
+			std::stringstream ss; // Convert the list element into doubles
+			ss << xml_process_noise[j];
+			ss >> mode.process_noise[j] ? mode.process_noise[j] : 0;
+		}
+		modes.push_back(mode);
+	}
+}
+
+bool GraftParameterManager::reloadParameters(std::vector<boost::shared_ptr<GraftSensor> >& topics, const size_t state_size, std::string& error){
+	// Read everything before changing anything
+	std::vector<double> process_noise = process_noise_;
+	try{
+		parseProcessNoise(process_noise);
+	} catch(...){
+		error = "XmlRpc error parsing process_noise";
+		return false;
+	}
+	if(process_noise.size() != state_size && process_noise.size() != state_size*state_size){
+		std::stringstream ss;
+		ss << "process_noise has " << process_noise.size() << " elements, expected " << state_size << " or " << state_size*state_size;
+		error = ss.str();
+		return false;
+	}
+
+	// A GraftIMM keeps the modes it started with, only their process noise changes
+	std::vector<GraftIMMMode> imm_modes;
+	if(imm_modes_.size() > 1){
+		try{
+			parseIMMModes(imm_modes);
+		} catch(...){
+			error = "XmlRpc error parsing imm_modes";
+			return false;
+		}
+		bool same_modes = imm_modes.size() == imm_modes_.size();
+		for(size_t i = 0; same_modes && i < imm_modes.size(); i++){
+			same_modes = imm_modes[i].name == imm_modes_[i].name;
+		}
+		if(!same_modes){
+			error = "imm_modes cannot be added, removed or renamed without restarting";
+			return false;
+		}
+		for(size_t i = 0; i < imm_modes.size(); i++){
+			size_t size = imm_modes[i].process_noise.size();
+			if(size != state_size && size != state_size*state_size){
+				std::stringstream ss;
+				ss << "imm_modes/" << imm_modes[i].name << "/process_noise has " << size << " elements, expected " << state_size << " or " << state_size*state_size;
+				error = ss.str();
+				return false;
+			}
+		}
+	}
+
+	double alpha, kappa, beta, recovery_inflation, update_deadline;
+	int max_recoveries;
+  pnh_.param<double>("alpha", alpha, alpha_);
+  pnh_.param<double>("kappa", kappa, kappa_);
+  pnh_.param<double>("beta", beta, beta_);
+  pnh_.param<double>("recovery_inflation", recovery_inflation, recovery_inflation_);
+  pnh_.param<int>("max_recoveries", max_recoveries, max_recoveries_);
+  pnh_.param<double>("update_deadline", update_deadline, update_deadline_);
+
+	// Topics, their usage, extrinsics and update groups are fixed at startup
+	std::vector<double> gate_probabilities(topics.size());
+	try{
+		for(size_t i = 0; i < topics.size(); i++){
+			ros::NodeHandle tnh(pnh_, "topics/" + topics[i]->getName());
+			topics[i]->stageTuning(tnh);
+			gate_probabilities[i] = parseGateProbability(tnh);
+		}
+	} catch(...){
+		error = "XmlRpc error parsing topic parameters";
+		return false;
+	}
+
+	// Nothing below can fail
+	process_noise_ = process_noise;
+	for(size_t i = 0; i < imm_modes.size(); i++){
+		imm_modes_[i].process_noise = imm_modes[i].process_noise;
+	}
+	alpha_ = alpha;
+	kappa_ = kappa;
+	beta_ = beta;
+	recovery_inflation_ = recovery_inflation;
+	max_recoveries_ = max_recoveries;
+	update_deadline_ = update_deadline;
+	for(size_t i = 0; i < topics.size(); i++){
+		topics[i]->commitTuning();
+		topics[i]->getGate().setProbability(gate_probabilities[i]);
+	}
+	return true;
+}
+
 std::string GraftParameterManager::getFilterType(){
 	return filter_type_;
 }
 
+std::vector<boost::shared_ptr<GraftOdometryTopic> > GraftParameterManager::getCascadeInputs(){
+	return cascade_inputs_;
+}
+
+std::string GraftParameterManager::getProcessModel(){
+	return process_model_;
+}
+
 bool GraftParameterManager::getPlanarOutput(){
 	return planar_output_;
 }
@@ -324,6 +447,14 @@ double GraftParameterManager::getUpdateRate(){
 	return update_rate_;
 }
 
+double GraftParameterManager::getOutputRate(){
+	return output_rate_;
+}
+
+std::vector<GraftUpdateGroup> GraftParameterManager::getUpdateGroups(){
+	return update_groups_;
+}
+
 std::string GraftParameterManager::getUpdateTopic(){
 	return update_topic_;
 }
@@ -344,6 +475,78 @@ bool GraftParameterManager::getPublishTF(){
   return publish_tf_;
 }
 
+std::string GraftParameterManager::getSharedMemoryName(){
+  return shared_memory_name_;
+}
+
+int GraftParameterManager::getStateHistorySize(){
+  return state_history_size_;
+}
+
+int GraftParameterManager::getSmootherLag(){
+  return std::max(smoother_lag_, 0);
+}
+
+bool GraftParameterManager::getInitializeFromMeasurements(){
+  return initialize_from_measurements_;
+}
+
+double GraftParameterManager::getInitializationTimeout(){
+  return initialization_timeout_;
+}
+
+double GraftParameterManager::getRecoveryInflation(){
+  return recovery_inflation_;
+}
+
+int GraftParameterManager::getMaxRecoveries(){
+  return max_recoveries_;
+}
+
+double GraftParameterManager::getUpdateDeadline(){
+  return update_deadline_;
+}
+
+void GraftParameterManager::setRealtimeQueue(ros::CallbackQueueInterface* queue){
+  realtime_queue_ = queue;
+}
+
+bool GraftParameterManager::getRealtime(){
+  return realtime_;
+}
+
+int GraftParameterManager::getRealtimePriority(){
+  return realtime_priority_;
+}
+
+int GraftParameterManager::getRealtimeCPU(){
+  return realtime_cpu_;
+}
+
+bool GraftParameterManager::getRealtimeLockMemory(){
+  return realtime_lock_memory_;
+}
+
+std::string GraftParameterManager::getCheckpointFile(){
+  return checkpoint_file_;
+}
+
+double GraftParameterManager::getCheckpointRate(){
+  return checkpoint_rate_;
+}
+
+double GraftParameterManager::getCheckpointMaxAge(){
+  return checkpoint_max_age_;
+}
+
+std::string GraftParameterManager::getFlightRecorderFile(){
+  return flight_recorder_file_;
+}
+
+size_t GraftParameterManager::getFlightRecorderSize(){
+  return std::max(flight_recorder_size_, 1)*size_t(1024*1024);
+}
+
 std::vector<double> GraftParameterManager::getInitialCovariance(){
   return initial_covariance_;
 }
@@ -352,6 +555,18 @@ std::vector<double> GraftParameterManager::getProcessNoise(){
 	return process_noise_;
 }
 
+std::vector<GraftIMMMode> GraftParameterManager::getIMMModes(){
+	return imm_modes_;
+}
+
+double GraftParameterManager::getIMMStayProbability(){
+	return imm_stay_probability_;
+}
+
+bool GraftParameterManager::getIMMThreads(){
+	return imm_threads_;
+}
+
 double GraftParameterManager::getAlpha(){
   return alpha_;
 }
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <graft/GraftPoseTopic.h>
+
+
+GraftPoseTopic::GraftPoseTopic(){
+	useAbsolutePose(true);
+}
+
+GraftPoseTopic::~GraftPoseTopic(){
+
+}
+
+void GraftPoseTopic::poseCallback(const geometry_msgs::PoseWithCovarianceStamped::ConstPtr& msg){
+	nav_msgs::Odometry::Ptr odom(new nav_msgs::Odometry());
+	odom->header = msg->header;
+	odom->child_frame_id = sensor_frame_id_;
+	odom->pose = msg->pose;
+	callback(odom);
+}
+
+void GraftPoseTopic::configure(ros::NodeHandle& tnh){
+	GraftOdometryTopic::configure(tnh);
+	bool absolute_pose, delta_pose;
+	tnh.param<bool>("delta_pose", delta_pose, false);
+	tnh.param<bool>("absolute_pose", absolute_pose, !delta_pose);
+	useAbsolutePose(absolute_pose);
+	useDeltaPose(delta_pose && !absolute_pose);
+	useVelocities(false); // No twist in the message
+	tnh.param<std::string>("sensor_frame_id", sensor_frame_id_, "");
+}
+
+ros::Subscriber GraftPoseTopic::subscribe(ros::NodeHandle& n, const std::string& topic, const uint32_t queue_size){
+	return n.subscribe(topic, queue_size, &GraftPoseTopic::poseCallback, this);
+}
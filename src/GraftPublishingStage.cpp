@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <graft/GraftPublishingStage.h>
+
+
+GraftPublishingStage::GraftPublishingStage(): slots_(SLOTS), pending_(0){
+	for(size_t i = 0; i < slots_.size(); i++){
+		free_.push(&slots_[i]);
+	}
+}
+
+GraftPublishingStage::~GraftPublishingStage(){
+	stop();
+}
+
+void GraftPublishingStage::start(PublishFunction publish){
+	stop();
+	publish_ = publish;
+	thread_ = boost::thread(&GraftPublishingStage::loop, this);
+}
+
+void GraftPublishingStage::stop(){
+	if(thread_.joinable()){
+		thread_.interrupt();
+		thread_.join();
+	}
+	drain();
+}
+
+GraftPublishSlot* GraftPublishingStage::acquire(){
+	GraftPublishSlot* slot = NULL;
+	if(!free_.pop(slot)){
+		return NULL;
+	}
+	return slot;
+}
+
+void GraftPublishingStage::commit(GraftPublishSlot* slot){
+	committed_.push(slot); // Never full, there are only SLOTS slots
+	{
+		boost::mutex::scoped_lock lock(wake_mutex_);
+		pending_++;
+	}
+	wake_.notify_one();
+}
+
+void GraftPublishingStage::drain(){
+	GraftPublishSlot* slot;
+	while(committed_.pop(slot)){
+		if(publish_){
+			publish_(*slot);
+		}
+		free_.push(slot);
+	}
+}
+
+void GraftPublishingStage::loop(){
+	try{
+		while(true){
+			{
+				boost::unique_lock<boost::mutex> lock(wake_mutex_);
+				while(pending_ == 0){
+					wake_.wait(lock);
+				}
+				pending_ = 0; // Every slot committed so far is in committed_
+			}
+			drain();
+		}
+	} catch(boost::thread_interrupted&){
+		// Stopped
+	}
+}
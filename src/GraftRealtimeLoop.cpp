@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <graft/GraftRealtimeLoop.h>
+#include <algorithm>
+#include <cmath>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+static int64_t monotonicNow(){
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t)now.tv_sec*1000000000LL + now.tv_nsec;
+}
+
+GraftRealtimeLoop::GraftRealtimeLoop(ros::CallbackQueue* queue, boost::mutex& mutex, UpdateFunction update, StatisticsFunction statistics):
+		queue_(queue), mutex_(mutex), update_(update), statistics_(statistics), priority_(0), cpu_(-1), lock_memory_(false),
+		last_report_(0), cycles_(0), overruns_(0), jitter_sum_(0.0), jitter_squared_sum_(0.0), jitter_max_(0.0), cycle_time_max_(0.0){
+
+}
+
+GraftRealtimeLoop::~GraftRealtimeLoop(){
+	stop();
+}
+
+void GraftRealtimeLoop::setPriority(const int priority){
+	priority_ = priority;
+}
+
+void GraftRealtimeLoop::setCPU(const int cpu){
+	cpu_ = cpu;
+}
+
+void GraftRealtimeLoop::setLockMemory(const bool lock_memory){
+	lock_memory_ = lock_memory;
+}
+
+void GraftRealtimeLoop::start(const std::vector<GraftUpdateGroup>& groups, const double idle_rate){
+	stop();
+	groups_.clear();
+	periods_.clear();
+	for(size_t i = 0; i < groups.size(); i++){
+		if(groups[i].rate > 1e-10){
+			groups_.push_back(groups[i]);
+			periods_.push_back((int64_t)(1e9/groups[i].rate));
+		}
+	}
+	if(groups_.empty()){ // Only arrival triggered groups, wake up to service the queue
+		GraftUpdateGroup idle;
+		idle.name = "idle";
+		idle.rate = idle_rate > 1e-10 ? idle_rate : 100.0;
+		idle.priority = 0;
+		groups_.push_back(idle);
+		periods_.push_back((int64_t)(1e9/idle.rate));
+	}
+	deadlines_.resize(groups_.size());
+
+	if(lock_memory_ && mlockall(MCL_CURRENT | MCL_FUTURE) != 0){
+		ROS_WARN("Could not lock the process memory for the real-time loop: %s", strerror(errno));
+	}
+	for(size_t i = 0; i < groups_.size(); i++){
+		ROS_INFO("Update group '%s': %zu topics at %.3f Hz on the real-time loop", groups_[i].name.c_str(), groups_[i].topics.size(), groups_[i].rate);
+	}
+	thread_ = boost::thread(&GraftRealtimeLoop::loop, this);
+}
+
+void GraftRealtimeLoop::stop(){
+	if(thread_.joinable()){
+		thread_.interrupt();
+		thread_.join();
+	}
+}
+
+void GraftRealtimeLoop::configureThread(){
+	if(cpu_ >= 0){
+		cpu_set_t cpus;
+		CPU_ZERO(&cpus);
+		CPU_SET(cpu_, &cpus);
+		int error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+		if(error != 0){
+			ROS_WARN("Could not pin the real-time loop to CPU %d: %s", cpu_, strerror(error));
+		}
+	}
+	if(priority_ > 0){
+		sched_param param;
+		memset(&param, 0, sizeof(param));
+		param.sched_priority = priority_;
+		int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+		if(error != 0){
+			ROS_WARN("Could not run the real-time loop at SCHED_FIFO priority %d: %s, check the rtprio limit.", priority_, strerror(error));
+		}
+	}
+	if(lock_memory_){
+		// Fault in the stack now instead of during a cycle
+		volatile unsigned char stack[64*1024];
+		for(size_t i = 0; i < sizeof(stack); i += 4096){
+			stack[i] = 0;
+		}
+	}
+}
+
+void GraftRealtimeLoop::loop(){
+	configureThread();
+	int64_t now = monotonicNow();
+	for(size_t i = 0; i < groups_.size(); i++){
+		deadlines_[i] = now + periods_[i];
+	}
+	last_report_ = now;
+
+	while(ros::ok() && !boost::this_thread::interruption_requested()){
+		int64_t deadline = deadlines_[0];
+		for(size_t i = 1; i < deadlines_.size(); i++){
+			deadline = std::min(deadline, deadlines_[i]);
+		}
+		timespec wake;
+		wake.tv_sec = deadline/1000000000LL;
+		wake.tv_nsec = deadline%1000000000LL;
+		while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) == EINTR){}
+		now = monotonicNow();
+		double jitter = (now - deadline)*1e-9;
+
+		{
+			boost::mutex::scoped_lock lock(mutex_);
+			queue_->callAvailable();
+			for(size_t i = 0; i < groups_.size(); i++){
+				if(deadlines_[i] > now){
+					continue;
+				}
+				if(!groups_[i].topics.empty()){
+					update_(groups_[i]);
+				}
+				deadlines_[i] += periods_[i];
+				if(deadlines_[i] <= now){ // More than a period behind, skip ahead instead of catching up in a burst
+					deadlines_[i] = now + periods_[i];
+				}
+			}
+		}
+
+		int64_t end = monotonicNow();
+		int64_t next = deadlines_[0];
+		for(size_t i = 1; i < deadlines_.size(); i++){
+			next = std::min(next, deadlines_[i]);
+		}
+		cycles_++;
+		if(end > next){
+			overruns_++;
+		}
+		jitter_sum_ += jitter;
+		jitter_squared_sum_ += jitter*jitter;
+		jitter_max_ = std::max(jitter_max_, jitter);
+		cycle_time_max_ = std::max(cycle_time_max_, (end - deadline)*1e-9);
+		if(end - last_report_ >= 1000000000LL){
+			report(end);
+		}
+	}
+}
+
+void GraftRealtimeLoop::report(const int64_t now){
+	graft::GraftRealtimeStatistics msg;
+	msg.header.stamp = ros::Time::now();
+	msg.cycles = cycles_;
+	msg.overruns = overruns_;
+	if(cycles_ > 0){
+		msg.jitter_mean = jitter_sum_/cycles_;
+		msg.jitter_stddev = std::sqrt(std::max(0.0, jitter_squared_sum_/cycles_ - msg.jitter_mean*msg.jitter_mean));
+	}
+	msg.jitter_max = jitter_max_;
+	msg.cycle_time_max = cycle_time_max_;
+	if(statistics_){
+		statistics_(msg);
+	}
+	last_report_ = now;
+	cycles_ = 0;
+	overruns_ = 0;
+	jitter_sum_ = 0.0;
+	jitter_squared_sum_ = 0.0;
+	jitter_max_ = 0.0;
+	cycle_time_max_ = 0.0;
+}
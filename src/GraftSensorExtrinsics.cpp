@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <graft/GraftSensorExtrinsics.h>
+
+
+GraftSensorExtrinsics::GraftSensorExtrinsics(): fixed_(false), resolved_(false), identity_(true){
+	set(Matrix3d::Identity(), Vector3d::Zero());
+}
+
+GraftSensorExtrinsics::~GraftSensorExtrinsics(){
+
+}
+
+static Matrix3d skew(const Vector3d& v){
+	Matrix3d out;
+	out << 0, -v(2), v(1),
+	       v(2), 0, -v(0),
+	       -v(1), v(0), 0;
+	return out;
+}
+
+void GraftSensorExtrinsics::set(const Matrix3d& rotation, const Vector3d& translation){
+	rotation_ = rotation;
+	translation_ = translation;
+	lever_arm_ = skew(translation_)*rotation_;
+	identity_ = rotation_.isIdentity(1e-12) && translation_.isZero(1e-12);
+}
+
+void GraftSensorExtrinsics::setTransform(const std::vector<double>& xyzrpy){
+	if(xyzrpy.size() != 6){
+		ROS_WARN("Sensor extrinsics require 6 elements (x, y, z, roll, pitch, yaw), got %zu.", xyzrpy.size());
+		return;
+	}
+	Matrix3d rotation;
+	rotation = AngleAxisd(xyzrpy[5], Vector3d::UnitZ())
+	         * AngleAxisd(xyzrpy[4], Vector3d::UnitY())
+	         * AngleAxisd(xyzrpy[3], Vector3d::UnitX());
+	set(rotation, Vector3d(xyzrpy[0], xyzrpy[1], xyzrpy[2]));
+	fixed_ = true;
+	resolved_ = true;
+}
+
+void GraftSensorExtrinsics::setTransformListener(const boost::shared_ptr<tf::TransformListener>& listener, const std::string& base_frame_id){
+	listener_ = listener;
+	base_frame_id_ = base_frame_id;
+	resolved_ = false;
+}
+
+bool GraftSensorExtrinsics::resolve(const std::string& sensor_frame_id){
+	if(fixed_ || listener_ == NULL){
+		return true; // Parameters or identity
+	}
+	if(resolved_ && sensor_frame_id == sensor_frame_id_){
+		return true;
+	}
+	if(sensor_frame_id.empty() || sensor_frame_id == base_frame_id_){
+		set(Matrix3d::Identity(), Vector3d::Zero());
+	} else {
+		tf::StampedTransform transform;
+		try{
+			listener_->lookupTransform(base_frame_id_, sensor_frame_id, ros::Time(0), transform);
+		} catch(tf::TransformException& ex){
+			ROS_WARN_THROTTLE(5.0, "Waiting for transform %s -> %s: %s", sensor_frame_id.c_str(), base_frame_id_.c_str(), ex.what());
+			return false;
+		}
+		tf::Quaternion q = transform.getRotation();
+		tf::Vector3 t = transform.getOrigin();
+		set(Quaterniond(q.w(), q.x(), q.y(), q.z()).normalized().toRotationMatrix(), Vector3d(t.x(), t.y(), t.z()));
+		ROS_INFO("Cached static transform %s -> %s", sensor_frame_id.c_str(), base_frame_id_.c_str());
+	}
+	sensor_frame_id_ = sensor_frame_id;
+	resolved_ = true;
+	return true;
+}
+
+bool GraftSensorExtrinsics::isIdentity(){
+	return identity_;
+}
+
+bool GraftSensorExtrinsics::isPositionOnly(const geometry_msgs::Pose& pose, const boost::array<double, 36>& covariance){
+	Quaterniond q(pose.orientation.w, pose.orientation.x, pose.orientation.y, pose.orientation.z);
+	if(q.squaredNorm() < 1e-10){
+		return true;
+	}
+	for(size_t i = 3; i < 6; i++){
+		if(covariance[i*6 + i] > 0.0){
+			return false;
+		}
+	}
+	return true;
+}
+
+void GraftSensorExtrinsics::transformPose(geometry_msgs::Pose& pose, boost::array<double, 36>& covariance){
+	if(identity_ || isPositionOnly(pose, covariance)){
+		return; // Without a measured orientation the lever arm direction is unknown here
+	}
+	// world_base = world_sensor * inverse(base_sensor)
+	Quaterniond q_ws(pose.orientation.w, pose.orientation.x, pose.orientation.y, pose.orientation.z);
+	Matrix3d r_ws = q_ws.normalized().toRotationMatrix();
+	Matrix3d r_wb = r_ws*rotation_.transpose();
+	Vector3d p_wb = Vector3d(pose.position.x, pose.position.y, pose.position.z) - r_wb*translation_;
+	Quaterniond q_wb(r_wb);
+	pose.position.x = p_wb(0);
+	pose.position.y = p_wb(1);
+	pose.position.z = p_wb(2);
+	pose.orientation.w = q_wb.w();
+	pose.orientation.x = q_wb.x();
+	pose.orientation.y = q_wb.y();
+	pose.orientation.z = q_wb.z();
+
+	// Orientation errors about the sensor axes -> about the base axes, d_base = R*d_sensor,
+	// and through the lever arm into the position, dp_base = dp_sensor + r_wb*[p]x*R*d_sensor
+	Matrix<double, 6, 6, RowMajor> cov = Map<Matrix<double, 6, 6, RowMajor> >(covariance.data());
+	Matrix<double, 6, 6> J = Matrix<double, 6, 6>::Identity();
+	J.block<3, 3>(0, 3) = r_wb*lever_arm_;
+	J.block<3, 3>(3, 3) = rotation_;
+	Map<Matrix<double, 6, 6, RowMajor> >(covariance.data()) = J*cov*J.transpose();
+}
+
+void GraftSensorExtrinsics::sensorPosition(geometry_msgs::Pose& pose){
+	if(identity_){
+		return;
+	}
+	// world_sensor = world_base * base_sensor
+	Quaterniond q_wb(pose.orientation.w, pose.orientation.x, pose.orientation.y, pose.orientation.z);
+	if(q_wb.squaredNorm() < 1e-10){
+		q_wb = Quaterniond::Identity();
+	}
+	Vector3d p_ws = Vector3d(pose.position.x, pose.position.y, pose.position.z) + q_wb.normalized()*translation_;
+	pose.position.x = p_ws(0);
+	pose.position.y = p_ws(1);
+	pose.position.z = p_ws(2);
+}
+
+void GraftSensorExtrinsics::transformTwist(geometry_msgs::Twist& twist, boost::array<double, 36>& covariance){
+	if(identity_){
+		return;
+	}
+	// v_base = R*v_sensor + [p]x*R*w_sensor, w_base = R*w_sensor
+	Vector3d v(twist.linear.x, twist.linear.y, twist.linear.z);
+	Vector3d w(twist.angular.x, twist.angular.y, twist.angular.z);
+	Vector3d v_base = rotation_*v + lever_arm_*w;
+	Vector3d w_base = rotation_*w;
+	twist.linear.x = v_base(0);
+	twist.linear.y = v_base(1);
+	twist.linear.z = v_base(2);
+	twist.angular.x = w_base(0);
+	twist.angular.y = w_base(1);
+	twist.angular.z = w_base(2);
+
+	Matrix<double, 6, 6, RowMajor> cov = Map<Matrix<double, 6, 6, RowMajor> >(covariance.data());
+	Matrix<double, 6, 6> J = Matrix<double, 6, 6>::Zero();
+	J.block<3, 3>(0, 0) = rotation_;
+	J.block<3, 3>(0, 3) = lever_arm_;
+	J.block<3, 3>(3, 3) = rotation_;
+	Map<Matrix<double, 6, 6, RowMajor> >(covariance.data()) = J*cov*J.transpose();
+}
+
+void GraftSensorExtrinsics::transformOrientation(geometry_msgs::Quaternion& orientation){
+	if(identity_){
+		return;
+	}
+	Quaterniond q_ws(orientation.w, orientation.x, orientation.y, orientation.z);
+	if(q_ws.squaredNorm() < 1e-10){
+		return; // No orientation reported
+	}
+	Quaterniond q_wb(q_ws.normalized().toRotationMatrix()*rotation_.transpose());
+	orientation.w = q_wb.w();
+	orientation.x = q_wb.x();
+	orientation.y = q_wb.y();
+	orientation.z = q_wb.z();
+}
+
+void GraftSensorExtrinsics::transformAngularVelocity(geometry_msgs::Vector3& angular_velocity, boost::array<double, 36>& covariance){
+	if(identity_){
+		return;
+	}
+	Vector3d w_base = rotation_*Vector3d(angular_velocity.x, angular_velocity.y, angular_velocity.z);
+	angular_velocity.x = w_base(0);
+	angular_velocity.y = w_base(1);
+	angular_velocity.z = w_base(2);
+
+	Map<Matrix<double, 6, 6, RowMajor> > cov(covariance.data());
+	Matrix3d block = cov.block<3, 3>(3, 3);
+	cov.block<3, 3>(3, 3) = rotation_*block*rotation_.transpose();
+}
+
+void GraftSensorExtrinsics::transformAcceleration(geometry_msgs::Vector3& accel, const geometry_msgs::Vector3& base_angular_velocity, boost::array<double, 9>& covariance){
+	if(identity_){
+		return;
+	}
+	// a_sensor = a_base + w x (w x p), angular acceleration is not observed
+	Vector3d w(base_angular_velocity.x, base_angular_velocity.y, base_angular_velocity.z);
+	Vector3d a_base = rotation_*Vector3d(accel.x, accel.y, accel.z) - w.cross(w.cross(translation_));
+	accel.x = a_base(0);
+	accel.y = a_base(1);
+	accel.z = a_base(2);
+
+	Map<Matrix<double, 3, 3, RowMajor> > cov(covariance.data());
+	Matrix3d block = cov;
+	cov = rotation_*block*rotation_.transpose();
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <graft/GraftSensorRegistry.h>
+#include <graft/GraftOdometryTopic.h>
+#include <graft/GraftImuTopic.h>
+#include <graft/GraftPoseTopic.h>
+#include <graft/GraftTwistTopic.h>
+#include <graft/GraftNavSatFixTopic.h>
+#include <graft/GraftJointStateTopic.h>
+
+template<class Sensor>
+boost::shared_ptr<GraftSensor> createSensor(){
+	return boost::shared_ptr<GraftSensor>(new Sensor());
+}
+
+GraftSensorRegistry::GraftSensorRegistry(){
+	add("nav_msgs/Odometry", &createSensor<GraftOdometryTopic>);
+	add("sensor_msgs/Imu", &createSensor<GraftImuTopic>);
+	add("geometry_msgs/PoseWithCovarianceStamped", &createSensor<GraftPoseTopic>);
+	add("geometry_msgs/TwistWithCovarianceStamped", &createSensor<GraftTwistTopic>);
+	add("sensor_msgs/NavSatFix", &createSensor<GraftNavSatFixTopic>);
+	add("sensor_msgs/JointState", &createSensor<GraftJointStateTopic>);
+}
+
+GraftSensorRegistry::~GraftSensorRegistry(){
+
+}
+
+void GraftSensorRegistry::add(const std::string& type, Factory factory){
+	factories_[type] = factory;
+}
+
+boost::shared_ptr<GraftSensor> GraftSensorRegistry::create(const std::string& type){
+	std::map<std::string, Factory>::iterator it = factories_.find(type);
+	if(it != factories_.end()){
+		return it->second();
+	}
+	try{
+		if(loader_ == NULL){
+			loader_.reset(new pluginlib::ClassLoader<GraftSensor>("graft", "GraftSensor"));
+		}
+		return loader_->createInstance(type);
+	} catch(pluginlib::PluginlibException& e){
+		ROS_ERROR("Could not load a GraftSensor plugin for %s: %s", type.c_str(), e.what());
+	}
+	return boost::shared_ptr<GraftSensor>();
+}
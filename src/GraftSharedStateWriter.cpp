@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <graft/GraftSharedStateWriter.h>
+#include <errno.h>
+#include <algorithm>
+
+
+GraftSharedStateWriter::GraftSharedStateWriter(): data_(NULL){
+
+}
+
+GraftSharedStateWriter::~GraftSharedStateWriter(){
+	close();
+}
+
+bool GraftSharedStateWriter::open(const std::string& name){
+	close();
+	name_ = name;
+	if(name_.empty() || name_[0] != '/'){
+		name_ = "/" + name_;
+	}
+	int fd = shm_open(name_.c_str(), O_CREAT | O_RDWR, 0644);
+	if(fd < 0){
+		ROS_ERROR("Could not open shared memory %s: %s", name_.c_str(), strerror(errno));
+		return false;
+	}
+	if(ftruncate(fd, sizeof(GraftSharedState)) != 0){
+		ROS_ERROR("Could not size shared memory %s: %s", name_.c_str(), strerror(errno));
+		::close(fd);
+		return false;
+	}
+	void* mem = mmap(NULL, sizeof(GraftSharedState), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+	if(mem == MAP_FAILED){
+		ROS_ERROR("Could not map shared memory %s: %s", name_.c_str(), strerror(errno));
+		return false;
+	}
+	data_ = static_cast<GraftSharedState*>(mem);
+
+	// Readers ignore the segment until the first estimate is written
+	__atomic_store_n(&data_->sequence, 0, __ATOMIC_RELAXED);
+	memset(&data_->estimate, 0, sizeof(GraftSharedEstimate));
+	data_->version = GRAFT_SHARED_STATE_VERSION;
+	__atomic_store_n(&data_->magic, GRAFT_SHARED_STATE_MAGIC, __ATOMIC_RELEASE);
+	ROS_INFO("Writing state to shared memory %s", name_.c_str());
+	return true;
+}
+
+void GraftSharedStateWriter::close(){
+	if(data_ != NULL){
+		munmap(data_, sizeof(GraftSharedState));
+		data_ = NULL;
+	}
+}
+
+bool GraftSharedStateWriter::isOpen(){
+	return data_ != NULL;
+}
+
+void GraftSharedStateWriter::write(const graft::GraftState& state, const size_t size){
+	if(data_ == NULL){
+		return;
+	}
+	uint32_t sequence = __atomic_load_n(&data_->sequence, __ATOMIC_RELAXED);
+	__atomic_store_n(&data_->sequence, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	size_t n = std::min<size_t>(size, 18);
+	GraftSharedEstimate& estimate = data_->estimate;
+	estimate.stamp_sec = state.header.stamp.sec;
+	estimate.stamp_nsec = state.header.stamp.nsec;
+	estimate.size = n;
+	estimate.position[0] = state.pose.position.x;
+	estimate.position[1] = state.pose.position.y;
+	estimate.position[2] = state.pose.position.z;
+	estimate.orientation[0] = state.pose.orientation.x;
+	estimate.orientation[1] = state.pose.orientation.y;
+	estimate.orientation[2] = state.pose.orientation.z;
+	estimate.orientation[3] = state.pose.orientation.w;
+	estimate.linear_velocity[0] = state.twist.linear.x;
+	estimate.linear_velocity[1] = state.twist.linear.y;
+	estimate.linear_velocity[2] = state.twist.linear.z;
+	estimate.angular_velocity[0] = state.twist.angular.x;
+	estimate.angular_velocity[1] = state.twist.angular.y;
+	estimate.angular_velocity[2] = state.twist.angular.z;
+	memcpy(estimate.covariance, &state.covariance[0], n*n*sizeof(double));
+
+	__atomic_store_n(&data_->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,812 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <sstream>
+#include <graft/GraftUKF.h>
+#include <graft/GraftAllocationAudit.h>
+#include <graft/GraftVelocityModel.h>
+#include <graft/GraftAttitudeModel.h>
+#include <graft/GraftAbsoluteModel.h>
+#include <graft/GraftInertialModel.h>
+#include <ros/console.h>
+
+template<class ProcessModel>
+GraftUKF<ProcessModel>::GraftUKF() : sigma_msgs_(2*SIZE+1), residuals_(2*SIZE+1), alpha_(0.001), beta_(2.0), kappa_(0.0), recovery_inflation_(10.0), max_recoveries_(3),
+                                             recoveries_(0), ready_(true), initialize_from_measurements_(false), initialized_(0),
+                                             initialization_timeout_(0.0), mean_only_prediction_(false), flight_recorder_(NULL),
+                                             update_rows_(0), log_likelihood_(0.0), log_likelihood_valid_(false), gate_mutex_(NULL), record_gates_(true)
+{
+	ProcessModel::initialState(graft_state_);
+	graft_covariance_.setIdentity();
+	initial_state_ = graft_state_;
+	initial_covariance_ = graft_covariance_;
+	Q_.setZero();
+	updateWeights();
+}
+
+template<class ProcessModel>
+GraftUKF<ProcessModel>::~GraftUKF(){
+
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::getMessageFromState(const StateVector& state, const CovarianceMatrix& covariance, graft::GraftState& msg){
+	ProcessModel::toMessage(state, msg);
+	for(size_t i = 0; i < SIZE*SIZE; i++){
+		msg.covariance[i] = covariance(i);
+	}
+}
+
+template<class ProcessModel>
+graft::GraftStatePtr GraftUKF<ProcessModel>::getMessageFromState(){
+	graft::GraftStatePtr msg(new graft::GraftState());
+	getMessageFromState(*msg);
+	return msg;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::getMessageFromState(graft::GraftState& msg){
+	getMessageFromState(graft_state_, graft_covariance_, msg);
+}
+
+template<class ProcessModel>
+graft::GraftStatePtr GraftUKF<ProcessModel>::getMessageAtTime(const ros::Time& stamp){
+	graft::GraftStatePtr msg(new graft::GraftState());
+	if(!getMessageAtTime(stamp, *msg)){
+		return graft::GraftStatePtr();
+	}
+	return msg;
+}
+
+template<class ProcessModel>
+bool GraftUKF<ProcessModel>::getMessageAtTime(const ros::Time& stamp, graft::GraftState& msg){
+	StateVector state;
+	CovarianceMatrix covariance;
+	ros::Time newest_stamp;
+	if(!history_.newest(newest_stamp, state, covariance)){ // No updates yet
+		getMessageFromState(msg);
+		return true;
+	}
+	if(stamp > newest_stamp){
+		// Predict only the mean forward, the covariance grows by one step of process noise
+		state = propagate(state, (stamp - newest_stamp).toSec(), &ProcessModel::extrapolate);
+		covariance = covariance + Q_;
+	} else if(!history_.interpolate(stamp, state, covariance)){
+		return false; // Older than the history
+	}
+	ProcessModel::normalize(state);
+	getMessageFromState(state, covariance, msg);
+	return true;
+}
+
+template<class ProcessModel>
+graft::GraftStateCompactPtr GraftUKF<ProcessModel>::getCompactMessageFromState(){
+	graft::GraftStateCompactPtr msg(new graft::GraftStateCompact());
+	getCompactMessageFromState(*msg);
+	return msg;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::getCompactMessageFromState(graft::GraftStateCompact& msg){
+	msg.state.resize(SIZE);
+	msg.covariance.resize(SIZE*(SIZE+1)/2);
+	size_t k = 0;
+	for(size_t i = 0; i < SIZE; i++){
+		msg.state[i] = graft_state_(i);
+		for(size_t j = i; j < SIZE; j++){ // Upper triangle, row-major
+			msg.covariance[k++] = graft_covariance_(i, j);
+		}
+	}
+}
+
+template<class ProcessModel>
+ros::Time GraftUKF<ProcessModel>::getStateTime(){
+	return last_update_time_;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::updateWeights(){
+	lambda_ = alpha_*alpha_*(SIZE + kappa_) - SIZE;
+	mean_weights_.setConstant(1.0/(2*(SIZE + lambda_)));
+	covariance_weights_ = mean_weights_;
+	mean_weights_(0) = lambda_ / (SIZE + lambda_);
+	covariance_weights_(0) = mean_weights_(0) + (1 - alpha_*alpha_ + beta_);
+}
+
+template<class ProcessModel>
+bool GraftUKF<ProcessModel>::generateSigmaPoints(const StateVector& mean, const CovarianceMatrix& covariance, SigmaPoints& sigma_points){
+	// Use LLT Cholesky decomposiion to create stable Matrix Sqrt
+	Eigen::LLT<CovarianceMatrix> llt(covariance);
+	if(llt.info() != Eigen::Success){
+		return false;
+	}
+	CovarianceMatrix sig_sqrt = GraftScalar(std::sqrt(SIZE + lambda_))*llt.matrixL().toDenseMatrix();
+	sigma_points.col(0) = mean;
+	for(size_t i = 0; i < SIZE; i++){
+		sigma_points.col(i+1) = mean + sig_sqrt.col(i);
+		sigma_points.col(i+1+SIZE) = mean - sig_sqrt.col(i);
+	}
+	return true;
+}
+
+template<class ProcessModel>
+const char* GraftUKF<ProcessModel>::checkHealth(const StateVector& state, const CovarianceMatrix& covariance){
+	if(!state.allFinite()){
+		return "non-finite state";
+	}
+	if(!covariance.allFinite()){
+		return "non-finite covariance";
+	}
+	if((covariance.diagonal().array() <= GraftScalar(0)).any()){
+		return "non-positive variance";
+	}
+	if(Eigen::LLT<CovarianceMatrix>(covariance).info() != Eigen::Success){
+		return "covariance not positive definite";
+	}
+	return NULL;
+}
+
+template<class ProcessModel>
+size_t GraftUKF<ProcessModel>::offendingTopic(const GraftVector& innovation, const GraftMatrix& innovation_covariance, double& nis){
+	size_t offender = 0;
+	nis = -1.0;
+	size_t begin = 0;
+	for(size_t i = 0; i < measurement_topics_.size(); i++){
+		double topic_nis = 0.0;
+		for(size_t j = begin; j < measurement_ends_[i]; j++){
+			topic_nis += innovation(j)*innovation(j)/innovation_covariance(j,j);
+		}
+		// NaN compares false, so a non-finite innovation always marks its topic
+		if(!(topic_nis <= nis)){
+			offender = measurement_topics_[i];
+			nis = topic_nis;
+		}
+		begin = measurement_ends_[i];
+	}
+	return offender;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::recover(const ros::Time& t, const char* reason, const std::string& topic, const double nis){
+	graft::GraftRecoveryEvent event;
+	event.header.stamp = t;
+	event.process_model = ProcessModel::name();
+	event.reason = reason;
+	event.topic = topic;
+	event.normalized_innovation = nis;
+	event.recoveries = ++recoveries_;
+	log_likelihood_valid_ = false; // Of the rejected estimate, not of the one rolled back to
+
+	ros::Time stamp;
+	event.reinitialized = recoveries_ > max_recoveries_ || !history_.newest(stamp, graft_state_, graft_covariance_);
+	smoother_.clear(); // The rolled back estimate does not follow from the window
+	if(event.reinitialized){
+		graft_state_ = initial_state_;
+		graft_covariance_ = initial_covariance_;
+		history_.clear();
+		recoveries_ = 0;
+		setInitializeFromMeasurements(initialize_from_measurements_, initialization_timeout_);
+		ROS_ERROR("The %s filter estimate was rejected (%s) %d times in a row, last by '%s', restarting from the initial state.",
+		          ProcessModel::name(), reason, event.recoveries, topic.c_str());
+	} else {
+		graft_covariance_ *= GraftScalar(recovery_inflation_);
+		ROS_ERROR("The %s filter estimate was rejected (%s), last by '%s' with normalized innovation %g, rolled back to %.3f.",
+		          ProcessModel::name(), reason, topic.c_str(), nis, stamp.toSec());
+	}
+	last_update_time_ = t;
+	if(ready_){
+		history_.add(t, graft_state_, graft_covariance_);
+	}
+	if(recovery_callback_){
+		recovery_callback_(event);
+	}
+}
+
+template<class ProcessModel>
+bool GraftUKF<ProcessModel>::getMeasurements(const std::vector<boost::shared_ptr<GraftSensor> >& topics, const Measurements& z, const SigmaPoints& sigma_points){
+	GraftAllocationScope scope(GraftAllocationAudit::MEASUREMENTS);
+	measurements_.clear();
+	measurement_topics_.clear();
+	measurement_ends_.clear();
+
+	// Convert the sigma points into messages once
+	for(size_t i = 0; i < sigma_msgs_.size(); i++){
+		ProcessModel::toMessage(sigma_points.col(i), sigma_msgs_[i]);
+	}
+
+	for(size_t i = 0; i < topics.size(); i++){
+		const graft::GraftSensorResidual::ConstPtr& meas = z[i];
+		uint32_t flight_topic = flight_recorder_ != NULL ? flightTopic(*topics[i]) : GRAFT_FLIGHT_RECORDER_TOPICS;
+		if(flight_topic < GRAFT_FLIGHT_RECORDER_TOPICS){
+			flight_cycle_.topics |= uint64_t(1) << flight_topic;
+			if(meas == NULL){
+				flight_cycle_.missing |= uint64_t(1) << flight_topic;
+			} else {
+				flight_recorder_->writeMeasurement(flight_topic, *meas);
+			}
+		}
+		if(meas == NULL){ // Timeout or not received or invalid, skip
+			continue;
+		}
+		scope.enter(GraftAllocationAudit::OBSERVATION);
+		for(size_t j = 0; j < sigma_msgs_.size(); j++){
+			topics[i]->h(sigma_msgs_[j], residuals_[j]);
+		}
+		scope.enter(GraftAllocationAudit::MEASUREMENTS);
+		ProcessModel::addMeasurements(*meas, residuals_, measurements_);
+		if(measurement_ends_.empty() || measurements_.size() > measurement_ends_.back()){
+			measurement_topics_.push_back(i);
+			measurement_ends_.push_back(measurements_.size());
+		}
+	}
+	resizeUpdate(measurements_.size());
+	return measurements_.size() > 0;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::predictMeasurements(GraftVector& z, GraftVector& predicted, GraftMatrix& deviations, GraftMatrix& covariance){
+	measurements_.get(z, measurement_noise_, measurement_sigma_points_);
+	predicted.noalias() = measurement_sigma_points_*mean_weights_;
+	deviations = measurement_sigma_points_.colwise() - predicted;
+	weighted_measurement_deviations_ = deviations*covariance_weights_.asDiagonal();
+	covariance.noalias() = weighted_measurement_deviations_*deviations.transpose();
+	covariance.diagonal() += measurement_noise_;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::resizeUpdate(const size_t rows){
+	if(rows == update_rows_){
+		return;
+	}
+	update_rows_ = rows;
+	measurement_.resize(rows);
+	measurement_noise_.resize(rows);
+	measurement_sigma_points_.resize(rows, 2*SIZE+1);
+	predicted_measurement_.resize(rows);
+	measurement_deviations_.resize(rows, 2*SIZE+1);
+	weighted_measurement_deviations_.resize(rows, 2*SIZE+1);
+	innovation_covariance_.resize(rows, rows);
+	innovation_covariance_inverse_.resize(rows, rows);
+	innovation_lu_ = Eigen::PartialPivLU<GraftMatrix>(rows);
+	innovation_ldlt_ = Eigen::LDLT<GraftMatrix>(rows);
+	innovation_.resize(rows);
+	weighted_innovation_.resize(rows);
+	cross_covariance_.resize(SIZE, rows);
+	gain_.resize(SIZE, rows);
+	gain_workspace_.resize(SIZE, rows);
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::computeGain(const StateVector& predicted_mean){
+	weighted_state_deviations_ = (sigma_points_.colwise() - predicted_mean)*covariance_weights_.asDiagonal();
+	cross_covariance_.noalias() = weighted_state_deviations_*measurement_deviations_.transpose();
+	innovation_lu_.compute(innovation_covariance_);
+	// Solved against the identity, inverse() would copy the decomposition
+	innovation_covariance_inverse_ = innovation_lu_.solve(GraftMatrix::Identity(update_rows_, update_rows_));
+	gain_.noalias() = cross_covariance_*innovation_covariance_inverse_;
+}
+
+template<class ProcessModel>
+bool GraftUKF<ProcessModel>::testGate(GraftInnovationGate& gate, const double nis, const size_t rows, double& threshold){
+	if(gate_mutex_ != NULL){
+		boost::mutex::scoped_lock lock(*gate_mutex_);
+		threshold = gate.threshold(rows);
+		return record_gates_ ? gate.test(nis, rows) : gate.accepts(nis, rows);
+	}
+	threshold = gate.threshold(rows);
+	return record_gates_ ? gate.test(nis, rows) : gate.accepts(nis, rows);
+}
+
+template<class ProcessModel>
+bool GraftUKF<ProcessModel>::gateMeasurements(std::vector<boost::shared_ptr<GraftSensor> >& topics, const GraftVector& innovation, const GraftMatrix& innovation_covariance){
+	bool rejected = false;
+	for(size_t i = measurement_topics_.size(); i-- > 0;){ // Backwards, so erasing keeps earlier rows in place
+		size_t begin = i > 0 ? measurement_ends_[i-1] : 0;
+		size_t rows = measurement_ends_[i] - begin;
+		// A topic's rows are few, so its block is decomposed without the heap
+		typedef Eigen::Matrix<GraftScalar, Eigen::Dynamic, 1, 0, GRAFT_MAX_TOPIC_ROWS, 1> TopicVector;
+		typedef Eigen::Matrix<GraftScalar, Eigen::Dynamic, Eigen::Dynamic, 0, GRAFT_MAX_TOPIC_ROWS, GRAFT_MAX_TOPIC_ROWS> TopicMatrix;
+		TopicVector y = innovation.segment(begin, rows);
+		TopicMatrix S = innovation_covariance.block(begin, begin, rows, rows);
+		Eigen::LDLT<TopicMatrix> ldlt(S);
+		TopicVector solved = ldlt.solve(y);
+		double nis = y.dot(solved);
+		GraftSensor& topic = *topics[measurement_topics_[i]];
+		double threshold;
+		if(testGate(topic.getGate(), nis, rows, threshold)){
+			continue;
+		}
+		ROS_WARN_THROTTLE(1.0, "Rejected a measurement from %s, normalized innovation %g is beyond %g.", topic.getName().c_str(), nis, threshold);
+		uint32_t flight_topic = flight_recorder_ != NULL ? flightTopic(topic) : GRAFT_FLIGHT_RECORDER_TOPICS;
+		if(flight_topic < GRAFT_FLIGHT_RECORDER_TOPICS){
+			flight_cycle_.rejected |= uint64_t(1) << flight_topic;
+		}
+		measurements_.erase(begin, measurement_ends_[i]);
+		for(size_t j = i + 1; j < measurement_ends_.size(); j++){
+			measurement_ends_[j] -= rows;
+		}
+		measurement_topics_.erase(measurement_topics_.begin() + i);
+		measurement_ends_.erase(measurement_ends_.begin() + i);
+		rejected = true;
+	}
+	return rejected;
+}
+
+void clearMessages(std::vector<boost::shared_ptr<GraftSensor> >& topics){
+	for(size_t i = 0; i < topics.size(); i++){
+		topics[i]->clearMessage();
+	}
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::initializeFromMeasurements(const ros::Time& t, const Measurements& z){
+	if(initialization_start_.isZero()){
+		initialization_start_ = t;
+	}
+	for(size_t i = 0; i < z.size(); i++){
+		if(z[i] != NULL){
+			initialized_ |= ProcessModel::initialize(*z[i], graft_state_, graft_covariance_);
+		}
+	}
+
+	unsigned int missing = ProcessModel::requiredInitialization() & ~initialized_;
+	bool timed_out = initialization_timeout_ > 0 && (t - initialization_start_).toSec() > initialization_timeout_;
+	if(missing != 0 && !timed_out){
+		return;
+	}
+	if(missing != 0){
+		ROS_WARN("The %s filter was not seeded with%s%s%s%s after %.1f seconds, starting from initial_covariance.", ProcessModel::name(),
+		         missing & GRAFT_INIT_POSITION ? " position" : "",
+		         missing & GRAFT_INIT_ORIENTATION ? " orientation" : "",
+		         missing & GRAFT_INIT_LINEAR_VELOCITY ? " linear velocity" : "",
+		         missing & GRAFT_INIT_ANGULAR_VELOCITY ? " angular velocity" : "",
+		         initialization_timeout_);
+	} else {
+		ROS_INFO("The %s filter was initialized from measurements.", ProcessModel::name());
+	}
+	ProcessModel::normalize(graft_state_);
+	ready_ = true;
+	last_update_time_ = t;
+	history_.add(t, graft_state_, graft_covariance_);
+}
+
+template<class ProcessModel>
+double GraftUKF<ProcessModel>::predictAndUpdate(){
+	return predictAndUpdate(topics_);
+}
+
+template<class ProcessModel>
+double GraftUKF<ProcessModel>::predictAndUpdate(std::vector<boost::shared_ptr<GraftSensor> >& topics){
+	if(topics.size() == 0 || topics[0] == NULL){
+		return 0;
+	}
+	readMeasurements(topics, z_);
+	bool consumed = false;
+	double dt = update(ros::Time::now(), topics, z_, consumed);
+	if(consumed){
+		clearMessages(topics);
+	}
+	return dt;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::readMeasurements(const std::vector<boost::shared_ptr<GraftSensor> >& topics, Measurements& z){
+	z.resize(topics.size());
+	for(size_t i = 0; i < topics.size(); i++){
+		z[i] = topics[i]->z();
+	}
+}
+
+template<class ProcessModel>
+double GraftUKF<ProcessModel>::update(const ros::Time& t, std::vector<boost::shared_ptr<GraftSensor> >& topics, const Measurements& z, bool& consumed){
+	log_likelihood_valid_ = false;
+	if(!ready_){
+		initializeFromMeasurements(t, z);
+		consumed = true;
+		return 0.0;
+	}
+	if(last_update_time_.toSec() < 0.0001){ // No previous updates
+		ROS_WARN("No previous update, skipping update.");
+		last_update_time_ = t;
+		return 0.0;
+	}
+	double dt = (t - last_update_time_).toSec();
+	if(flight_recorder_ != NULL){
+		flight_cycle_.stamp_sec = t.sec;
+		flight_cycle_.stamp_nsec = t.nsec;
+		flight_cycle_.dt = dt;
+		flight_cycle_.topics = 0;
+		flight_cycle_.missing = 0;
+		flight_cycle_.rejected = 0;
+	}
+
+	// Prediction
+	GraftAllocationScope scope(GraftAllocationAudit::PREDICTION);
+	StateVector predicted_mean;
+	CovarianceMatrix predicted_covariance;
+	if(mean_only_prediction_){ // Shedding load, the covariance only grows by Q
+		predicted_mean = propagate(graft_state_, dt);
+		predicted_covariance = graft_covariance_ + Q_;
+		smoother_.predict(predicted_mean, predicted_covariance, NULL);
+	} else {
+		if(!generateSigmaPoints(graft_state_, graft_covariance_, sigma_points_)){
+			recover(t, "covariance not positive definite", "", 0.0);
+			recordCycle(GRAFT_FLIGHT_RECOVERED);
+			consumed = true;
+			return 0.0;
+		}
+		for(size_t i = 0; i < sigma_points_.cols(); i++){
+			predicted_sigma_points_.col(i) = propagate(sigma_points_.col(i), dt);
+		}
+		predicted_mean = predicted_sigma_points_*mean_weights_;
+		SigmaPoints predicted_deviations = predicted_sigma_points_.colwise() - predicted_mean;
+		predicted_covariance = predicted_deviations*covariance_weights_.asDiagonal()*predicted_deviations.transpose() + Q_;
+		if(smoother_.getLag() > 0){
+			CovarianceMatrix cross_covariance = (sigma_points_.colwise() - graft_state_)*covariance_weights_.asDiagonal()*predicted_deviations.transpose();
+			smoother_.predict(predicted_mean, predicted_covariance, &cross_covariance);
+		}
+	}
+
+	const char* reason = checkHealth(predicted_mean, predicted_covariance);
+	if(reason != NULL || !generateSigmaPoints(predicted_mean, predicted_covariance, sigma_points_)){
+		recover(t, reason != NULL ? reason : "covariance not positive definite", "", 0.0);
+		recordCycle(GRAFT_FLIGHT_RECOVERED);
+		consumed = true;
+		return 0.0;
+	}
+
+	// Update
+	if(!getMeasurements(topics, z, sigma_points_)){
+		recordCycle(GRAFT_FLIGHT_NO_MEASUREMENTS);
+		return 0.0; // No measurements, the next update predicts over this interval too
+	}
+	scope.enter(GraftAllocationAudit::UPDATE);
+	last_update_time_ = t;
+	predictMeasurements(measurement_, predicted_measurement_, measurement_deviations_, innovation_covariance_);
+	innovation_ = measurement_ - predicted_measurement_;
+	if(gate_mutex_ != NULL){
+		updateLogLikelihood(innovation_, innovation_covariance_);
+	}
+
+	// Outliers are dropped before they reach the gain
+	if(gateMeasurements(topics, innovation_, innovation_covariance_)){
+		if(measurements_.size() == 0){ // All rejected, the prediction is the estimate
+			graft_state_ = predicted_mean;
+			ProcessModel::normalize(graft_state_);
+			graft_covariance_ = predicted_covariance;
+			history_.add(t, graft_state_, graft_covariance_);
+			smoother_.add(t, graft_state_, graft_covariance_);
+			recordCycle(GRAFT_FLIGHT_ALL_REJECTED);
+			consumed = true;
+			return dt;
+		}
+		scope.enter(GraftAllocationAudit::MEASUREMENTS); // Fewer rows now
+		resizeUpdate(measurements_.size());
+		scope.enter(GraftAllocationAudit::UPDATE);
+		predictMeasurements(measurement_, predicted_measurement_, measurement_deviations_, innovation_covariance_);
+		innovation_ = measurement_ - predicted_measurement_;
+	}
+	computeGain(predicted_mean);
+
+	graft_state_ = predicted_mean;
+	graft_state_.noalias() += gain_*innovation_;
+	ProcessModel::normalize(graft_state_);
+	josephCovarianceUpdate(predicted_covariance, gain_, cross_covariance_, innovation_covariance_, gain_workspace_);
+	graft_covariance_ = predicted_covariance;
+
+	reason = checkHealth(graft_state_, graft_covariance_);
+	if(reason != NULL){
+		double nis;
+		size_t offender = offendingTopic(innovation_, innovation_covariance_, nis);
+		if(z[offender]){
+			ROS_ERROR_STREAM("Measurement from " << topics[offender]->getName() << ": " << *z[offender]);
+		}
+		recover(t, reason, topics[offender]->getName(), nis);
+		recordCycle(GRAFT_FLIGHT_RECOVERED);
+	} else {
+		recoveries_ = 0;
+		history_.add(t, graft_state_, graft_covariance_);
+		smoother_.add(t, graft_state_, graft_covariance_);
+		recordCycle(GRAFT_FLIGHT_UPDATED);
+	}
+
+	consumed = true;
+	return dt;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::updateLogLikelihood(const GraftVector& innovation, const GraftMatrix& innovation_covariance){
+	innovation_ldlt_.compute(innovation_covariance);
+	double log_determinant = innovation_ldlt_.vectorD().array().log().sum();
+	weighted_innovation_ = innovation_ldlt_.solve(innovation);
+	log_likelihood_ = -0.5*(innovation.dot(weighted_innovation_) + log_determinant + innovation.size()*std::log(2.0*M_PI));
+	log_likelihood_valid_ = std::isfinite(log_likelihood_);
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::setTopics(std::vector<boost::shared_ptr<GraftSensor> >& topics){
+	topics_ = topics;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::setInitialCovariance(std::vector<double>& P){
+	graft_covariance_.setZero();
+	if(P.size() == SIZE*SIZE){ // Full matrix
+		for(size_t i = 0; i < P.size(); i++){
+			graft_covariance_(i) = P[i];
+		}
+	} else if(P.size() == SIZE){ // Diagonal matrix
+		for(size_t i = 0; i < P.size(); i++){
+			graft_covariance_(i*(SIZE+1)) = P[i];
+		}
+	} else { // Not specified correctly
+		ROS_ERROR("initial_covariance is size %zu, expected %d for the %s model.\nUsing 0.1*Identity.\nThis probably won't work well.", P.size(), SIZE*SIZE, ProcessModel::name());
+		graft_covariance_.setIdentity();
+		graft_covariance_ = 0.1 * graft_covariance_;
+	}
+	initial_covariance_ = graft_covariance_;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::setProcessNoise(std::vector<double>& Q){
+	Q_.setZero();
+	if(Q.size() == SIZE*SIZE){ // Full process nosie matrix
+		for(size_t i = 0; i < Q.size(); i++){
+			Q_(i) = Q[i];
+		}
+	} else if(Q.size() == SIZE){ // Diagonal matrix
+		for(size_t i = 0; i < Q.size(); i++){
+			Q_(i*(SIZE+1)) = Q[i];
+		}
+	} else { // Not specified correctly
+		ROS_ERROR("process_noise parameter is size %zu, expected %d for the %s model.\nUsing 0.1*Identity.\nThis probably won't work well.", Q.size(), SIZE*SIZE, ProcessModel::name());
+		Q_.setIdentity();
+		Q_ = 0.1 * Q_;
+	}
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::setModeProcessNoise(std::vector<std::vector<double> >& Q){
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::setAlpha(const double alpha){
+#ifdef GRAFT_USE_FLOAT
+	if(alpha < 0.1){
+		ROS_WARN("alpha %g is too small for a float build, the covariance may lose precision.  Use 0.1 or more.", alpha);
+	}
+#endif
+	alpha_ = alpha;
+	updateWeights();
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::setKappa(const double kappa){
+	kappa_ = kappa;
+	updateWeights();
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::setBeta(const double beta){
+	beta_ = beta;
+	updateWeights();
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::setStateHistorySize(const size_t size){
+	history_.setCapacity(size);
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::setInitializeFromMeasurements(const bool initialize, const double timeout){
+	initialize_from_measurements_ = initialize;
+	ready_ = !initialize;
+	initialized_ = 0;
+	initialization_start_ = ros::Time();
+	initialization_timeout_ = timeout;
+}
+
+template<class ProcessModel>
+bool GraftUKF<ProcessModel>::isReady(){
+	return ready_;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::setRecovery(const double inflation, const int max_recoveries){
+	recovery_inflation_ = inflation;
+	max_recoveries_ = max_recoveries;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::setRecoveryCallback(RecoveryFunction callback){
+	recovery_callback_ = callback;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::setMeanOnlyPrediction(const bool mean_only){
+	mean_only_prediction_ = mean_only;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::setFlightRecorder(GraftFlightRecorder* recorder){
+	flight_recorder_ = recorder;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::setSmootherLag(const size_t lag){
+	smoother_.setLag(lag);
+}
+
+template<class ProcessModel>
+bool GraftUKF<ProcessModel>::getSmoothedMessage(graft::GraftState& msg){
+	ros::Time stamp;
+	StateVector state;
+	CovarianceMatrix covariance;
+	if(!smoother_.smoothed(stamp, state, covariance)){
+		return false;
+	}
+	ProcessModel::normalize(state);
+	getMessageFromState(state, covariance, msg);
+	msg.header.stamp = stamp;
+	return true;
+}
+
+template<class ProcessModel>
+uint32_t GraftUKF<ProcessModel>::flightTopic(const GraftSensor& topic){
+	for(size_t i = 0; i < topics_.size() && i < GRAFT_FLIGHT_RECORDER_TOPICS; i++){
+		if(topics_[i].get() == &topic){
+			return i;
+		}
+	}
+	return GRAFT_FLIGHT_RECORDER_TOPICS;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::recordCycle(const GraftFlightOutcome outcome){
+	if(flight_recorder_ == NULL){
+		return;
+	}
+	flight_cycle_.outcome = outcome;
+	flight_cycle_.size = outcome == GRAFT_FLIGHT_NO_MEASUREMENTS ? 0 : SIZE;
+	flight_recorder_->writeCycle(flight_cycle_, graft_state_.data(), graft_covariance_.data());
+}
+
+template<class ProcessModel>
+typename GraftUKF<ProcessModel>::StateVector GraftUKF<ProcessModel>::propagate(const StateVector& x, const double dt, StepFunction step){
+	// Steps of at most maxTimeStep, so long gaps are integrated in full instead of cut short
+	StateVector out = x;
+	double remaining = dt;
+	const double max_step = ProcessModel::maxTimeStep();
+	while(max_step > 0 && remaining > max_step){
+		out = step(out, max_step);
+		remaining -= max_step;
+	}
+	return step(out, remaining);
+}
+
+template<class ProcessModel>
+bool GraftUKF<ProcessModel>::getPosterior(std::vector<double>& state, std::vector<double>& covariance){
+	if(!ready_){
+		return false;
+	}
+	state.resize(SIZE);
+	covariance.resize(SIZE*SIZE);
+	for(size_t i = 0; i < SIZE; i++){
+		state[i] = graft_state_(i);
+		for(size_t j = 0; j < SIZE; j++){
+			covariance[i*SIZE+j] = graft_covariance_(i,j);
+		}
+	}
+	return true;
+}
+
+template<class ProcessModel>
+bool GraftUKF<ProcessModel>::restorePosterior(const ros::Time& stamp, const std::vector<double>& state, const std::vector<double>& covariance){
+	if(state.size() != SIZE || covariance.size() != SIZE*SIZE){
+		return false;
+	}
+	StateVector x;
+	CovarianceMatrix P;
+	for(size_t i = 0; i < SIZE; i++){
+		x(i) = state[i];
+		for(size_t j = 0; j < SIZE; j++){
+			P(i,j) = covariance[i*SIZE+j];
+		}
+	}
+	const char* reason = checkHealth(x, P);
+	if(reason == NULL && !P.isApprox(P.transpose())){
+		reason = "covariance not symmetric";
+	}
+	if(reason != NULL){
+		ROS_WARN("Rejecting the checkpointed posterior, %s.", reason);
+		return false;
+	}
+	ProcessModel::normalize(x);
+	graft_state_ = x;
+	graft_covariance_ = P;
+	ready_ = true;
+	// The first update predicts over the time the filter was down
+	last_update_time_ = stamp;
+	history_.add(last_update_time_, graft_state_, graft_covariance_);
+	smoother_.clear();
+	return true;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::setPosterior(const ros::Time& t, const StateVector& state, const CovarianceMatrix& covariance){
+	graft_state_ = state;
+	graft_covariance_ = covariance;
+	ready_ = true;
+	last_update_time_ = t;
+	history_.add(t, graft_state_, graft_covariance_);
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::setIMMMode(boost::mutex* gate_mutex){
+	gate_mutex_ = gate_mutex;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::setRecordGates(const bool record){
+	record_gates_ = record;
+}
+
+template<class ProcessModel>
+bool GraftUKF<ProcessModel>::getLogLikelihood(double& log_likelihood){
+	log_likelihood = log_likelihood_;
+	return log_likelihood_valid_;
+}
+
+template<class ProcessModel>
+size_t GraftUKF<ProcessModel>::size(){
+	return SIZE;
+}
+
+template<class ProcessModel>
+void GraftUKF<ProcessModel>::updateOdometry(const graft::GraftState& state, const double dt, nav_msgs::Odometry& odom){
+	ProcessModel::toOdometry(state, dt, odom);
+}
+
+template class GraftUKF<GraftVelocityModel>;
+template class GraftUKF<GraftAttitudeModel>;
+template class GraftUKF<GraftAbsoluteModel>;
+template class GraftUKF<GraftInertialModel>;
+
+boost::shared_ptr<GraftFilter> createGraftFilter(const std::string& process_model){
+	if(process_model == GraftVelocityModel::name()){
+		return boost::shared_ptr<GraftFilter>(new GraftUKF<GraftVelocityModel>());
+	} else if(process_model == GraftAttitudeModel::name()){
+		return boost::shared_ptr<GraftFilter>(new GraftUKF<GraftAttitudeModel>());
+	} else if(process_model == GraftAbsoluteModel::name()){
+		return boost::shared_ptr<GraftFilter>(new GraftUKF<GraftAbsoluteModel>());
+	} else if(process_model == GraftInertialModel::name()){
+		return boost::shared_ptr<GraftFilter>(new GraftUKF<GraftInertialModel>());
+	}
+	return boost::shared_ptr<GraftFilter>();
+}
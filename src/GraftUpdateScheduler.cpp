@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <graft/GraftUpdateScheduler.h>
+
+
+GraftUpdateScheduler::GraftUpdateScheduler(ros::NodeHandle n, UpdateFunction update): n_(n), update_(update){
+
+}
+
+GraftUpdateScheduler::~GraftUpdateScheduler(){
+	for(size_t i = 0; i < groups_.size(); i++){
+		for(size_t j = 0; j < groups_[i].topics.size(); j++){
+			groups_[i].topics[j]->setArrivalCallback(boost::function<void()>());
+		}
+	}
+}
+
+void GraftUpdateScheduler::setGroups(const std::vector<GraftUpdateGroup>& groups){
+	groups_ = groups;
+	timers_.clear();
+	for(size_t i = 0; i < groups_.size(); i++){
+		if(groups_[i].rate > 1e-10){
+			ROS_INFO("Update group '%s': %zu topics at %.3f Hz", groups_[i].name.c_str(), groups_[i].topics.size(), groups_[i].rate);
+			timers_.push_back(n_.createTimer(ros::Duration(1.0/groups_[i].rate), boost::bind(&GraftUpdateScheduler::timerCallback, this, _1, i)));
+		} else {
+			ROS_INFO("Update group '%s': %zu topics on arrival", groups_[i].name.c_str(), groups_[i].topics.size());
+			for(size_t j = 0; j < groups_[i].topics.size(); j++){
+				groups_[i].topics[j]->setArrivalCallback(boost::bind(&GraftUpdateScheduler::arrivalCallback, this, i));
+			}
+		}
+	}
+}
+
+void GraftUpdateScheduler::timerCallback(const ros::TimerEvent& event, size_t group){
+	update_(groups_[group]);
+}
+
+void GraftUpdateScheduler::arrivalCallback(size_t group){
+	update_(groups_[group]);
+}
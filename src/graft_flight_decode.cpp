@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Decodes a flight recorder file, see graft/GraftFlightRecord.h.
+//
+//   graft_flight_decode <file> <prefix>      writes <prefix>_updates.csv and <prefix>_measurements.csv
+//   graft_flight_decode <file> <name>.bag    writes a bag for offline replay
+//
+// The bag holds the measurements as graft/GraftSensorResidual on
+// flight_recorder/<topic> and each estimate as graft/GraftState on
+// flight_recorder/state, stamped with the time of their update.  In the CSV
+// files the measurements of an update come just before its sequence number.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include <rosbag/bag.h>
+#include <graft/GraftFlightRecord.h>
+#include <graft/GraftSensorResidual.h>
+#include <graft/GraftState.h>
+#include <graft/GraftVelocityModel.h>
+#include <graft/GraftAttitudeModel.h>
+#include <graft/GraftAbsoluteModel.h>
+#include <graft/GraftInertialModel.h>
+
+static const char* outcomeName(const uint32_t outcome){
+	switch(outcome){
+		case GRAFT_FLIGHT_UPDATED: return "updated";
+		case GRAFT_FLIGHT_NO_MEASUREMENTS: return "no_measurements";
+		case GRAFT_FLIGHT_ALL_REJECTED: return "all_rejected";
+		case GRAFT_FLIGHT_RECOVERED: return "recovered";
+		default: return "unknown";
+	}
+}
+
+// Names of the topics set in mask, separated by spaces
+static std::string topicNames(const GraftFlightRecorderReader& reader, const uint64_t mask){
+	std::string names;
+	for(uint32_t i = 0; i < GRAFT_FLIGHT_RECORDER_TOPICS; i++){
+		if(mask & (uint64_t(1) << i)){
+			names += (names.empty() ? "" : " ") + reader.topicName(i);
+		}
+	}
+	return names;
+}
+
+template<class ProcessModel>
+bool toState(const GraftFlightRecordHeader* record, graft::GraftState& msg){
+	const GraftFlightCycle& cycle = GraftFlightRecorderReader::cycle(record);
+	if(cycle.size != ProcessModel::SIZE){
+		return false;
+	}
+	typename ProcessModel::StateVector x;
+	const double* state = GraftFlightRecorderReader::state(record);
+	for(size_t i = 0; i < ProcessModel::SIZE; i++){
+		x(i) = state[i];
+	}
+	ProcessModel::toMessage(x, msg);
+	const double* covariance = GraftFlightRecorderReader::covariance(record);
+	for(size_t i = 0; i < cycle.size*cycle.size; i++){
+		msg.covariance[i] = covariance[i];
+	}
+	msg.header.stamp = ros::Time(cycle.stamp_sec, cycle.stamp_nsec);
+	return true;
+}
+
+static bool toState(const std::string& process_model, const GraftFlightRecordHeader* record, graft::GraftState& msg){
+	if(process_model == GraftVelocityModel::name()){
+		return toState<GraftVelocityModel>(record, msg);
+	} else if(process_model == GraftAttitudeModel::name()){
+		return toState<GraftAttitudeModel>(record, msg);
+	} else if(process_model == GraftAbsoluteModel::name()){
+		return toState<GraftAbsoluteModel>(record, msg);
+	} else if(process_model == GraftInertialModel::name()){
+		return toState<GraftInertialModel>(record, msg);
+	}
+	return false;
+}
+
+static void toResidual(const GraftFlightRecorderReader& reader, const GraftFlightMeasurement& m, graft::GraftSensorResidual& msg){
+	msg.header.stamp = ros::Time(m.stamp_sec, m.stamp_nsec);
+	msg.name = reader.topicName(m.topic);
+	msg.pose.position.x = m.pose[0];
+	msg.pose.position.y = m.pose[1];
+	msg.pose.position.z = m.pose[2];
+	msg.pose.orientation.x = m.pose[3];
+	msg.pose.orientation.y = m.pose[4];
+	msg.pose.orientation.z = m.pose[5];
+	msg.pose.orientation.w = m.pose[6];
+	msg.twist.linear.x = m.twist[0];
+	msg.twist.linear.y = m.twist[1];
+	msg.twist.linear.z = m.twist[2];
+	msg.twist.angular.x = m.twist[3];
+	msg.twist.angular.y = m.twist[4];
+	msg.twist.angular.z = m.twist[5];
+	msg.accel.x = m.accel[0];
+	msg.accel.y = m.accel[1];
+	msg.accel.z = m.accel[2];
+	for(size_t i = 0; i < 36; i++){
+		msg.pose_covariance[i] = m.pose_covariance[i];
+		msg.twist_covariance[i] = m.twist_covariance[i];
+	}
+	for(size_t i = 0; i < 9; i++){
+		msg.accel_covariance[i] = m.accel_covariance[i];
+	}
+}
+
+static int writeBag(const GraftFlightRecorderReader& reader, const std::vector<const GraftFlightRecordHeader*>& records, const std::string& path){
+	std::string process_model(reader.header().process_model, strnlen(reader.header().process_model, GRAFT_FLIGHT_RECORDER_NAME));
+	rosbag::Bag bag;
+	bag.open(path, rosbag::bagmode::Write);
+	std::vector<graft::GraftSensorResidual> measurements; // Of the next update
+	for(size_t i = 0; i < records.size(); i++){
+		if(records[i]->type == GRAFT_FLIGHT_MEASUREMENT){
+			graft::GraftSensorResidual msg;
+			toResidual(reader, GraftFlightRecorderReader::measurement(records[i]), msg);
+			measurements.push_back(msg);
+			continue;
+		}
+		const GraftFlightCycle& cycle = GraftFlightRecorderReader::cycle(records[i]);
+		ros::Time t(cycle.stamp_sec, cycle.stamp_nsec);
+		for(size_t j = 0; j < measurements.size(); j++){
+			bag.write("flight_recorder/" + measurements[j].name, t, measurements[j]);
+		}
+		measurements.clear();
+		graft::GraftState state;
+		if(cycle.size > 0 && toState(process_model, records[i], state)){
+			bag.write("flight_recorder/state", t, state);
+		}
+	}
+	bag.close();
+	return 0;
+}
+
+static int writeCSV(const GraftFlightRecorderReader& reader, const std::vector<const GraftFlightRecordHeader*>& records, const std::string& prefix){
+	std::string updates_path = prefix + "_updates.csv";
+	std::string measurements_path = prefix + "_measurements.csv";
+	FILE* updates = fopen(updates_path.c_str(), "w");
+	FILE* measurements = fopen(measurements_path.c_str(), "w");
+	if(updates == NULL || measurements == NULL){
+		fprintf(stderr, "Could not write %s and %s.\n", updates_path.c_str(), measurements_path.c_str());
+		return 1;
+	}
+	fprintf(updates, "sequence,stamp,dt,outcome,topics,missing,rejected,state,covariance\n");
+	fprintf(measurements, "sequence,topic,stamp,x,y,z,qx,qy,qz,qw,vx,vy,vz,wx,wy,wz,ax,ay,az,pose_covariance,twist_covariance,accel_covariance\n");
+	for(size_t i = 0; i < records.size(); i++){
+		const GraftFlightRecordHeader* record = records[i];
+		if(record->type == GRAFT_FLIGHT_MEASUREMENT){
+			const GraftFlightMeasurement& m = GraftFlightRecorderReader::measurement(record);
+			fprintf(measurements, "%llu,%s,%u.%09u", (unsigned long long)record->sequence, reader.topicName(m.topic).c_str(), m.stamp_sec, m.stamp_nsec);
+			const double* values[] = {m.pose, m.twist, m.accel};
+			const size_t sizes[] = {7, 6, 3};
+			for(size_t j = 0; j < 3; j++){
+				for(size_t k = 0; k < sizes[j]; k++){
+					fprintf(measurements, ",%.17g", values[j][k]);
+				}
+			}
+			const double* covariances[] = {m.pose_covariance, m.twist_covariance, m.accel_covariance};
+			const size_t covariance_sizes[] = {36, 36, 9};
+			for(size_t j = 0; j < 3; j++){ // Space separated within a column
+				fprintf(measurements, ",");
+				for(size_t k = 0; k < covariance_sizes[j]; k++){
+					fprintf(measurements, k > 0 ? " %.17g" : "%.17g", covariances[j][k]);
+				}
+			}
+			fprintf(measurements, "\n");
+			continue;
+		}
+		const GraftFlightCycle& cycle = GraftFlightRecorderReader::cycle(record);
+		fprintf(updates, "%llu,%u.%09u,%.9f,%s,%s,%s,%s,", (unsigned long long)record->sequence, cycle.stamp_sec, cycle.stamp_nsec, cycle.dt,
+		        outcomeName(cycle.outcome), topicNames(reader, cycle.topics).c_str(),
+		        topicNames(reader, cycle.missing).c_str(), topicNames(reader, cycle.rejected).c_str());
+		const double* state = GraftFlightRecorderReader::state(record);
+		for(size_t j = 0; j < cycle.size; j++){
+			fprintf(updates, j > 0 ? " %.17g" : "%.17g", state[j]);
+		}
+		fprintf(updates, ",");
+		const double* covariance = GraftFlightRecorderReader::covariance(record);
+		for(size_t j = 0; j < cycle.size*cycle.size; j++){
+			fprintf(updates, j > 0 ? " %.17g" : "%.17g", covariance[j]);
+		}
+		fprintf(updates, "\n");
+	}
+	fclose(updates);
+	fclose(measurements);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if(argc != 3){
+		fprintf(stderr, "Usage: graft_flight_decode <file> <prefix for CSV files, or a .bag>\n");
+		return 2;
+	}
+	GraftFlightRecorderReader reader;
+	if(!reader.open(argv[1])){
+		fprintf(stderr, "%s is not a graft flight recorder file.\n", argv[1]);
+		return 1;
+	}
+	std::vector<const GraftFlightRecordHeader*> records;
+	reader.records(records);
+	fprintf(stderr, "%lu records of the %s filter.\n", (unsigned long)records.size(), reader.header().process_model);
+
+	std::string output = argv[2];
+	if(output.size() > 4 && output.compare(output.size() - 4, 4, ".bag") == 0){
+		return writeBag(reader, records, output);
+	}
+	return writeCSV(reader, records, output);
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <ros/ros.h>
+#include <ros/callback_queue.h>
+#include <boost/thread.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <graft/GraftFilterNode.h>
+
+// Runs an attitude filter and an absolute filter in one process, each on its
+// own thread and callback queue.  Every attitude odometry estimate is handed
+// to the absolute filter's cascade_input topics without a ROS hop.
+//
+// Parameters are read from ~attitude and ~absolute, see test_cascade.launch.
+
+// Single producer (attitude thread), single consumer (absolute thread)
+typedef boost::lockfree::spsc_queue<nav_msgs::Odometry, boost::lockfree::capacity<16> > CascadeQueue;
+
+CascadeQueue cascade_queue;
+
+void pushAttitude(const nav_msgs::Odometry& odom){
+	if(!cascade_queue.push(odom)){
+		ROS_WARN_THROTTLE(1.0, "Absolute stage is falling behind, dropping an attitude estimate.");
+	}
+}
+
+void attitudeLoop(ros::CallbackQueue* queue){
+	while(ros::ok()){
+		queue->callAvailable(ros::WallDuration(0.01));
+	}
+}
+
+void absoluteLoop(ros::CallbackQueue* queue, std::vector<boost::shared_ptr<GraftOdometryTopic> > inputs){
+	nav_msgs::Odometry odom;
+	while(ros::ok()){
+		// Short wait so handed over estimates are picked up within a millisecond
+		queue->callAvailable(ros::WallDuration(0.001));
+		while(cascade_queue.pop(odom)){
+			nav_msgs::Odometry::Ptr msg(new nav_msgs::Odometry(odom));
+			for(size_t i = 0; i < inputs.size(); i++){
+				inputs[i]->callback(msg);
+			}
+		}
+	}
+}
+
+int main(int argc, char **argv)
+{
+	ros::init(argc, argv, "graft_ukf_cascade");
+	ros::NodeHandle n;
+	ros::NodeHandle pnh("~");
+
+	// Each stage services its own topics, timers and services
+	ros::CallbackQueue attitude_queue;
+	ros::NodeHandle attitude_n(n, "attitude");
+	ros::NodeHandle attitude_pnh(pnh, "attitude");
+	attitude_n.setCallbackQueue(&attitude_queue);
+	attitude_pnh.setCallbackQueue(&attitude_queue);
+
+	ros::CallbackQueue absolute_queue;
+	ros::NodeHandle absolute_n(n);
+	ros::NodeHandle absolute_pnh(pnh, "absolute");
+	absolute_n.setCallbackQueue(&absolute_queue);
+	absolute_pnh.setCallbackQueue(&absolute_queue);
+
+	GraftFilterNode attitude(attitude_n, attitude_pnh);
+	GraftFilterNode absolute(absolute_n, absolute_pnh);
+	if(!attitude.init() || !absolute.init()){
+		return 1;
+	}
+
+	std::vector<boost::shared_ptr<GraftOdometryTopic> > inputs = absolute.getParameterManager().getCascadeInputs();
+	if(inputs.empty()){
+		ROS_WARN("No topic in ~absolute/topics sets cascade_input, the attitude estimate is not fused.");
+	}
+	attitude.setOdometryCallback(pushAttitude);
+
+	boost::thread attitude_thread(attitudeLoop, &attitude_queue);
+	boost::thread absolute_thread(absoluteLoop, &absolute_queue, inputs);
+
+	// Spin
+	ros::spin();
+
+	attitude_thread.join();
+	absolute_thread.join();
+}
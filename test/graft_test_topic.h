@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef GRAFT_TEST_TOPIC_H
+#define GRAFT_TEST_TOPIC_H
+
+#include <string>
+#include <vector>
+#include <ros/ros.h>
+#include <graft/GraftAbsoluteModel.h>
+#include <graft/GraftSensor.h>
+#include <graft/GraftUKF.h>
+
+// Serves the measurement set by a test, measured by the state like an
+// Odometry topic.  A topic that keeps its measurement serves it again after
+// each update, as a topic does between two messages; otherwise it is served
+// once.
+class GraftTestTopic : public GraftSensor{
+  public:
+    GraftTestTopic(const std::string& name, const bool keep_measurement):
+        name_(name), keep_measurement_(keep_measurement){}
+
+    void configure(ros::NodeHandle& tnh){}
+
+    ros::Subscriber subscribe(ros::NodeHandle& n, const std::string& topic, const uint32_t queue_size){
+      return ros::Subscriber();
+    }
+
+    graft::GraftSensorResidual::Ptr z(){
+      return measurement_;
+    }
+
+    void h(const graft::GraftState& state, graft::GraftSensorResidual& out){
+      out.header = state.header;
+      out.name = name_;
+      out.pose = state.pose;
+      out.twist = state.twist;
+    }
+
+    void setName(const std::string& name){
+      name_ = name;
+    }
+
+    std::string getName(){
+      return name_;
+    }
+
+    void clearMessage(){
+      if(!keep_measurement_){
+        measurement_.reset();
+      }
+    }
+
+    void setMeasurement(const graft::GraftSensorResidual& measurement){
+      measurement_.reset(new graft::GraftSensorResidual(measurement));
+    }
+
+  private:
+    std::string name_;
+    bool keep_measurement_;
+    graft::GraftSensorResidual::Ptr measurement_;
+};
+
+// Absolute model filter the tests share, seeded from its first measurements
+inline void configureTestFilter(GraftUKF<GraftAbsoluteModel>& ukf){
+  std::vector<double> P(GraftAbsoluteModel::SIZE, 1.0);
+  std::vector<double> Q(GraftAbsoluteModel::SIZE, 1e-2);
+  ukf.setInitialCovariance(P);
+  ukf.setProcessNoise(Q);
+  ukf.setInitializeFromMeasurements(true, 0.0);
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include <graft/GraftAbsoluteModel.h>
+#include <graft/GraftAllocationAudit.h>
+#include <graft/GraftUKF.h>
+#include "graft_test_topic.h"
+
+// Runs the absolute model filter until its buffers have grown to the
+// measurements it sees, then checks that further updates with the same
+// measurements never reach the heap in any stage, getMeasurements and h()
+// included.  z() hands out the same measurement, as a topic does between two
+// messages.  Only built with GRAFT_ALLOCATION_AUDIT, which counts the
+// allocations.
+
+static const int WARM_UP_CYCLES = 20;
+static const int AUDITED_CYCLES = 200;
+
+TEST(AllocationAudit, SteadyStateUpdatesDoNotAllocate){
+  ASSERT_TRUE(GraftAllocationAudit::enabled());
+
+  graft::GraftSensorResidual pose;
+  pose.pose.position.x = 1.0;
+  pose.pose.position.y = 2.0;
+  pose.pose.orientation.w = 1.0;
+  pose.pose_covariance[0] = pose.pose_covariance[7] = pose.pose_covariance[14] = 0.25;
+  pose.pose_covariance[21] = pose.pose_covariance[28] = pose.pose_covariance[35] = 0.01;
+  graft::GraftSensorResidual twist;
+  twist.twist.linear.x = 0.5;
+  twist.twist.angular.z = 0.1;
+  twist.twist_covariance[0] = twist.twist_covariance[7] = twist.twist_covariance[14] = 0.01;
+  twist.twist_covariance[21] = twist.twist_covariance[28] = twist.twist_covariance[35] = 0.01;
+  boost::shared_ptr<GraftTestTopic> pose_topic(new GraftTestTopic("pose", true));
+  boost::shared_ptr<GraftTestTopic> twist_topic(new GraftTestTopic("twist", true));
+  pose_topic->setMeasurement(pose);
+  twist_topic->setMeasurement(twist);
+  std::vector<boost::shared_ptr<GraftSensor> > topics;
+  topics.push_back(pose_topic);
+  topics.push_back(twist_topic);
+
+  GraftUKF<GraftAbsoluteModel> ukf;
+  configureTestFilter(ukf);
+
+  ros::Time t(1000.0);
+  for(int i = 0; i < WARM_UP_CYCLES; i++){
+    t += ros::Duration(0.1);
+    ros::Time::setNow(t);
+    ukf.predictAndUpdate(topics);
+  }
+  ASSERT_TRUE(ukf.isReady());
+
+  GraftAllocationAudit::Counts before;
+  GraftAllocationAudit::get(before);
+  int updates = 0;
+  for(int i = 0; i < AUDITED_CYCLES; i++){
+    t += ros::Duration(0.1);
+    ros::Time::setNow(t);
+    updates += ukf.predictAndUpdate(topics) > 0.0;
+  }
+  GraftAllocationAudit::Counts after;
+  GraftAllocationAudit::get(after);
+  ASSERT_EQ(AUDITED_CYCLES, updates);
+
+  for(size_t i = 0; i < GraftAllocationAudit::STAGES; i++){
+    printf("%s: %llu allocations over %d updates\n", GraftAllocationAudit::name(static_cast<GraftAllocationAudit::Stage>(i)),
+           (unsigned long long)(after.allocations[i] - before.allocations[i]), AUDITED_CYCLES);
+    EXPECT_EQ(0u, after.allocations[i] - before.allocations[i]) << GraftAllocationAudit::name(static_cast<GraftAllocationAudit::Stage>(i));
+  }
+}
+
+int main(int argc, char** argv){
+  testing::InitGoogleTest(&argc, argv);
+  ros::Time::init();
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <vector>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include <graft/GraftIMM.h>
+#include <graft/GraftVelocityModel.h>
+#include "graft_test_topic.h"
+
+// A mode rejected after its likelihood was computed must not be weighed by
+// it: the update leaves the mode probabilities where the mixing predicted
+// them.
+//
+// The topic measures linear x offset by 1 at the sigma points where linear y
+// and angular z are both within 0.5 of zero.  That is all the sigma points
+// of a mode with a narrow spread, a plain offset, but only the center and
+// the linear x points of a wide one.  With beta -1 the center weighs
+// negatively, so the innovation covariance of the wide mode drops below its
+// prior linear x variance while staying positive: the likelihood is finite
+// and the posterior variance negative.
+class GraftSpreadTopic : public GraftTestTopic{
+  public:
+    GraftSpreadTopic() : GraftTestTopic("spread", false){}
+
+    void h(const graft::GraftState& state, graft::GraftSensorResidual& out){
+      GraftTestTopic::h(state, out);
+      if(std::fabs(state.twist.linear.y) < 0.5 && std::fabs(state.twist.angular.z) < 0.5){
+        out.twist.linear.x += 1.0;
+      }
+    }
+};
+
+static int recoveries = 0;
+
+static void countRecovery(const graft::GraftRecoveryEvent& event){
+  recoveries++;
+}
+
+TEST(IMMRecovery, RecoveredModeKeepsPredictedProbabilities){
+  std::vector<GraftIMMMode> modes(2);
+  modes[0].name = "quiet";
+  modes[0].probability = 0.8;
+  modes[0].process_noise.assign(GraftVelocityModel::SIZE, 1e-6);
+  modes[1].name = "maneuver";
+  modes[1].probability = 0.2;
+  modes[1].process_noise.assign(GraftVelocityModel::SIZE, 1.0);
+  const double stay_probability = 0.95;
+  GraftIMM<GraftVelocityModel> imm(modes, stay_probability, false);
+  std::vector<double> P(GraftVelocityModel::SIZE, 1e-2);
+  imm.setInitialCovariance(P);
+  imm.setAlpha(1.0);
+  imm.setBeta(-1.0);
+  imm.setRecoveryCallback(countRecovery);
+
+  graft::GraftSensorResidual twist;
+  twist.twist_covariance[0] = 1e-4;
+  boost::shared_ptr<GraftSpreadTopic> topic(new GraftSpreadTopic());
+  std::vector<boost::shared_ptr<GraftSensor> > topics(1, topic);
+
+  ros::Time t(1000.0);
+  ros::Time::setNow(t);
+  topic->setMeasurement(twist);
+  imm.predictAndUpdate(topics); // Only sets the time of the first update
+  ASSERT_EQ(0, recoveries);
+
+  std::vector<double> prior = imm.getModeProbabilities();
+  std::vector<double> predicted(2);
+  predicted[0] = stay_probability*prior[0] + (1.0 - stay_probability)*prior[1];
+  predicted[1] = (1.0 - stay_probability)*prior[0] + stay_probability*prior[1];
+
+  t += ros::Duration(0.1);
+  ros::Time::setNow(t);
+  topic->setMeasurement(twist);
+  imm.predictAndUpdate(topics);
+  ASSERT_EQ(1, recoveries); // The maneuver mode only
+  EXPECT_NEAR(predicted[0], imm.getModeProbabilities()[0], 1e-9);
+  EXPECT_NEAR(predicted[1], imm.getModeProbabilities()[1], 1e-9);
+}
+
+int main(int argc, char** argv){
+  testing::InitGoogleTest(&argc, argv);
+  ros::Time::init();
+  return RUN_ALL_TESTS();
+}
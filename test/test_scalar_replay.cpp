@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2013, Willow Garage, Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the name of the Willow Garage, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived from
+ *       this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+#include <ros/ros.h>
+#include <graft/GraftAbsoluteModel.h>
+#include <graft/GraftUKF.h>
+#include "graft_test_topic.h"
+
+// Replays recorded measurements through the absolute model and compares the
+// trajectory with the one of the double build in
+// test/data/absolute_replay_reference.csv.  Built once with double and once
+// with GRAFT_USE_FLOAT.  The double build regenerates the reference when
+// GRAFT_WRITE_REPLAY_REFERENCE is set, after an intended change to the filter.
+
+#ifdef GRAFT_USE_FLOAT
+// Float against double over the whole drive
+static const double POSITION_TOLERANCE = 1e-3; // m
+static const double ORIENTATION_TOLERANCE = 1e-5; // rad
+static const double VELOCITY_TOLERANCE = 1e-5; // m/s and rad/s
+#else
+// Double against itself, allowing for compiler and platform differences
+static const double POSITION_TOLERANCE = 1e-9;
+static const double ORIENTATION_TOLERANCE = 1e-9;
+static const double VELOCITY_TOLERANCE = 1e-9;
+#endif
+
+// One row of graft_flight_decode's measurements CSV
+struct ReplayMeasurement{
+  std::string topic;
+  ros::Time stamp;
+  graft::GraftSensorResidual residual;
+};
+
+static void parseValues(const std::string& text, double* values, const size_t size){
+  std::stringstream ss(text);
+  for(size_t i = 0; i < size; i++){
+    ss >> values[i];
+  }
+}
+
+static bool readMeasurements(const std::string& path, std::vector<ReplayMeasurement>& measurements){
+  std::ifstream file(path.c_str());
+  std::string line;
+  if(!std::getline(file, line)){ // Header
+    return false;
+  }
+  while(std::getline(file, line)){
+    std::vector<std::string> columns;
+    std::stringstream ss(line);
+    std::string column;
+    while(std::getline(ss, column, ',')){
+      columns.push_back(column);
+    }
+    if(columns.size() != 22){
+      return false;
+    }
+    ReplayMeasurement m;
+    m.topic = columns[1];
+    m.stamp.fromSec(std::atof(columns[2].c_str()));
+    double values[16];
+    for(size_t i = 0; i < 16; i++){
+      values[i] = std::atof(columns[3 + i].c_str());
+    }
+    graft::GraftSensorResidual& r = m.residual;
+    r.header.stamp = m.stamp;
+    r.name = m.topic;
+    r.pose.position.x = values[0];
+    r.pose.position.y = values[1];
+    r.pose.position.z = values[2];
+    r.pose.orientation.x = values[3];
+    r.pose.orientation.y = values[4];
+    r.pose.orientation.z = values[5];
+    r.pose.orientation.w = values[6];
+    r.twist.linear.x = values[7];
+    r.twist.linear.y = values[8];
+    r.twist.linear.z = values[9];
+    r.twist.angular.x = values[10];
+    r.twist.angular.y = values[11];
+    r.twist.angular.z = values[12];
+    r.accel.x = values[13];
+    r.accel.y = values[14];
+    r.accel.z = values[15];
+    parseValues(columns[19], r.pose_covariance.data(), 36);
+    parseValues(columns[20], r.twist_covariance.data(), 36);
+    parseValues(columns[21], r.accel_covariance.data(), 9);
+    measurements.push_back(m);
+  }
+  return !measurements.empty();
+}
+
+// x, y, z, qw, qx, qy, qz, vx, vy, vz, wx, wy, wz after each update with the measurements of one stamp
+static void replay(const std::vector<ReplayMeasurement>& measurements, std::vector<std::vector<double> >& trajectory){
+  GraftUKF<GraftAbsoluteModel> ukf;
+  configureTestFilter(ukf);
+  ukf.setAlpha(0.5); // Float builds need the sigma points well apart, see GraftScalar.h
+
+  std::vector<boost::shared_ptr<GraftSensor> > topics;
+  std::vector<boost::shared_ptr<GraftTestTopic> > replay_topics;
+  size_t i = 0;
+  while(i < measurements.size()){
+    ros::Time stamp = measurements[i].stamp;
+    for(; i < measurements.size() && measurements[i].stamp == stamp; i++){
+      size_t j = 0;
+      while(j < replay_topics.size() && replay_topics[j]->getName() != measurements[i].topic){
+        j++;
+      }
+      if(j == replay_topics.size()){
+        replay_topics.push_back(boost::shared_ptr<GraftTestTopic>(new GraftTestTopic(measurements[i].topic, false)));
+        topics.push_back(replay_topics[j]);
+      }
+      replay_topics[j]->setMeasurement(measurements[i].residual);
+    }
+    ros::Time::setNow(stamp);
+    ukf.predictAndUpdate(topics);
+    if(!ukf.isReady()){
+      continue;
+    }
+    graft::GraftState state;
+    ukf.getMessageFromState(state);
+    double values[] = {state.pose.position.x, state.pose.position.y, state.pose.position.z,
+                       state.pose.orientation.w, state.pose.orientation.x, state.pose.orientation.y, state.pose.orientation.z,
+                       state.twist.linear.x, state.twist.linear.y, state.twist.linear.z,
+                       state.twist.angular.x, state.twist.angular.y, state.twist.angular.z};
+    trajectory.push_back(std::vector<double>(values, values + 13));
+  }
+}
+
+static bool readTrajectory(const std::string& path, std::vector<std::vector<double> >& trajectory){
+  std::ifstream file(path.c_str());
+  std::string line;
+  while(std::getline(file, line)){
+    std::vector<double> values(13);
+    parseValues(line, &values[0], values.size());
+    trajectory.push_back(values);
+  }
+  return !trajectory.empty();
+}
+
+#ifndef GRAFT_USE_FLOAT
+static void writeTrajectory(const std::string& path, const std::vector<std::vector<double> >& trajectory){
+  FILE* file = fopen(path.c_str(), "w");
+  ASSERT_TRUE(file != NULL);
+  for(size_t i = 0; i < trajectory.size(); i++){
+    for(size_t j = 0; j < trajectory[i].size(); j++){
+      fprintf(file, j > 0 ? " %.17g" : "%.17g", trajectory[i][j]);
+    }
+    fprintf(file, "\n");
+  }
+  fclose(file);
+}
+#endif
+
+TEST(ScalarReplay, MatchesDoubleTrajectory){
+  std::vector<ReplayMeasurement> measurements;
+  ASSERT_TRUE(readMeasurements(std::string(GRAFT_TEST_DATA) + "/absolute_replay_measurements.csv", measurements));
+  std::vector<std::vector<double> > trajectory;
+  replay(measurements, trajectory);
+  ASSERT_GT(trajectory.size(), 500u);
+
+  std::string reference_path = std::string(GRAFT_TEST_DATA) + "/absolute_replay_reference.csv";
+#ifndef GRAFT_USE_FLOAT
+  if(getenv("GRAFT_WRITE_REPLAY_REFERENCE") != NULL){
+    writeTrajectory(reference_path, trajectory);
+  }
+#endif
+  std::vector<std::vector<double> > reference;
+  ASSERT_TRUE(readTrajectory(reference_path, reference));
+  ASSERT_EQ(reference.size(), trajectory.size());
+
+  double position_error = 0.0;
+  double orientation_error = 0.0;
+  double velocity_error = 0.0;
+  for(size_t i = 0; i < trajectory.size(); i++){
+    const std::vector<double>& x = trajectory[i];
+    const std::vector<double>& r = reference[i];
+    for(size_t j = 0; j < 3; j++){
+      position_error = std::max(position_error, std::abs(x[j] - r[j]));
+    }
+    // 2|q - r| is the angle between close orientations, q and -q are the same
+    double sign = x[3]*r[3] + x[4]*r[4] + x[5]*r[5] + x[6]*r[6] < 0.0 ? -1.0 : 1.0;
+    double distance = 0.0;
+    for(size_t j = 3; j < 7; j++){
+      distance += std::pow(sign*x[j] - r[j], 2);
+    }
+    orientation_error = std::max(orientation_error, 2.0*std::sqrt(distance));
+    for(size_t j = 7; j < 13; j++){
+      velocity_error = std::max(velocity_error, std::abs(x[j] - r[j]));
+    }
+  }
+  printf("Largest difference over %zu updates: position %g m, orientation %g rad, velocity %g\n",
+         trajectory.size(), position_error, orientation_error, velocity_error);
+  EXPECT_LT(position_error, POSITION_TOLERANCE);
+  EXPECT_LT(orientation_error, ORIENTATION_TOLERANCE);
+  EXPECT_LT(velocity_error, VELOCITY_TOLERANCE);
+}
+
+int main(int argc, char** argv){
+  testing::InitGoogleTest(&argc, argv);
+  ros::Time::init();
+  return RUN_ALL_TESTS();
+}